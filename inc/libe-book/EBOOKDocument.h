@@ -13,19 +13,7 @@
 #include <librevenge/librevenge.h>
 #include <librevenge-stream/librevenge-stream.h>
 
-#ifdef DLL_EXPORT
-#ifdef LIBE_BOOK_BUILD
-#define EBOOKAPI __declspec(dllexport)
-#else
-#define EBOOKAPI __declspec(dllimport)
-#endif
-#else // !DLL_EXPORT
-#ifdef LIBE_BOOK_VISIBILITY
-#define EBOOKAPI __attribute__((visibility("default")))
-#else
-#define EBOOKAPI
-#endif
-#endif
+#include "libe-book-api.h"
 
 namespace libebook
 {
@@ -100,9 +88,55 @@ public:
     TYPE_RESERVED9 //< reserved for future use
   };
 
+  /** Result of format detection, together with the data read during it.
+    *
+    * A handle allows to parse a document without detecting its format
+    * again. The handle does not own the input stream, so the stream must
+    * outlive it.
+    */
+  class Handle;
+
   static EBOOKAPI Confidence isSupported(librevenge::RVNGInputStream *input, Type *type = nullptr);
   static EBOOKAPI Result parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document, const char *password = nullptr);
   static EBOOKAPI Result parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document, Type type, const char *password = nullptr);
+
+  /** Detect format of the input and keep the result.
+    *
+    * @arg[in] input the input stream
+    * @arg[out] confidence the likelihood that the format is supported
+    * @arg[out] type the detected type
+    * @return a newly allocated handle, or nullptr if the format is not
+    *         supported. The handle must be freed by close().
+    */
+  static EBOOKAPI Handle *open(librevenge::RVNGInputStream *input, Confidence *confidence = nullptr, Type *type = nullptr);
+  static EBOOKAPI Result parse(Handle *handle, librevenge::RVNGTextInterface *document, const char *password = nullptr);
+  static EBOOKAPI void close(Handle *handle);
+
+  /** Parse only the metadata of the document.
+    *
+    * Only startDocument(), setDocumentMetaData() and endDocument() are
+    * called on @c document. Most formats stop reading as soon as the
+    * metadata are known, which is much faster than a full parse.
+    *
+    * @arg[in] input the input stream
+    * @arg[in] document the output document generator
+    * @arg[in] password the password for encrypted documents
+    * @return the result of parsing
+    */
+  static EBOOKAPI Result parseMetadata(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document, const char *password = nullptr);
+  static EBOOKAPI Result parseMetadata(Handle *handle, librevenge::RVNGTextInterface *document, const char *password = nullptr);
+
+  /** Set the max. number of threads used to parse the document.
+    *
+    * Some formats (currently BBeB, PalmDoc and TealDoc) can decode
+    * independent parts of a document in worker threads; the output is
+    * the same as from the serial parse. The default is 1, i.e.,
+    * everything is done in the calling thread.
+    *
+    * @arg[in] handle the handle of the document
+    * @arg[in] count the number of threads; 0 is treated as 1
+    */
+  static EBOOKAPI void setThreadCount(Handle *handle, unsigned count);
 };
 
 } // namespace libebook
@@ -0,0 +1,71 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef LIBE_BOOK_EBOOKMAPPEDFILESTREAM_H_INCLUDED
+#define LIBE_BOOK_EBOOKMAPPEDFILESTREAM_H_INCLUDED
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "libe-book-api.h"
+
+namespace libebook
+{
+
+/** Input stream reading a file mapped into memory.
+  *
+  * The whole file is mapped at once, so read() never copies data. If the
+  * file cannot be mapped, it is read into memory instead. If the file
+  * cannot be opened at all, the stream is empty.
+  *
+  * The stream is never structured. Packages (e.g., ePub) must be opened
+  * by librevenge::RVNGFileStream.
+  */
+class EBOOKAPI EBOOKMappedFileStream : public librevenge::RVNGInputStream
+{
+  struct Impl;
+
+// disable copying
+  EBOOKMappedFileStream(const EBOOKMappedFileStream &other);
+  EBOOKMappedFileStream &operator=(const EBOOKMappedFileStream &other);
+
+public:
+  /** Open a file.
+    *
+    * @arg[in] filename the name of the file
+    */
+  explicit EBOOKMappedFileStream(const char *filename);
+  ~EBOOKMappedFileStream() override;
+
+  /** Check if the file has been opened successfully.
+    *
+    * @return true if the file is open
+    */
+  bool isOpen() const;
+
+  bool isStructured() override;
+  unsigned subStreamCount() override;
+  const char *subStreamName(unsigned id) override;
+  bool existsSubStream(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamByName(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamById(unsigned id) override;
+
+  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
+  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
+  long tell() override;
+  bool isEnd() override;
+
+private:
+  Impl *const m_impl;
+};
+
+} // namespace libebook
+
+#endif // LIBE_BOOK_EBOOKMAPPEDFILESTREAM_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
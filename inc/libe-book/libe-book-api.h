@@ -0,0 +1,29 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef LIBE_BOOK_LIBE_BOOK_API_H_INCLUDED
+#define LIBE_BOOK_LIBE_BOOK_API_H_INCLUDED
+
+#ifdef DLL_EXPORT
+#ifdef LIBE_BOOK_BUILD
+#define EBOOKAPI __declspec(dllexport)
+#else
+#define EBOOKAPI __declspec(dllimport)
+#endif
+#else // !DLL_EXPORT
+#ifdef LIBE_BOOK_VISIBILITY
+#define EBOOKAPI __attribute__((visibility("default")))
+#else
+#define EBOOKAPI
+#endif
+#endif
+
+#endif // LIBE_BOOK_LIBE_BOOK_API_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -11,6 +11,7 @@
 #define LIBE_BOOK_LIBE_BOOK_H_INCLUDED
 
 #include "EBOOKDocument.h"
+#include "EBOOKMappedFileStream.h"
 
 #endif // LIBE_BOOK_LIBE_BOOK_H_INCLUDED
 
@@ -0,0 +1,49 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef EBOOK2COMMON_H_INCLUDED
+#define EBOOK2COMMON_H_INCLUDED
+
+#include <memory>
+#include <string.h>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include <libe-book/libe-book.h>
+
+namespace ebook2common
+{
+
+/** Open an input file for one of the converters.
+  *
+  * Packages need the zip support of RVNGFileStream, everything else can
+  * be mapped. This is not done in the library, because it does not link
+  * librevenge-stream.
+  *
+  * @arg[in] file the path of the file.
+  * @return a new input stream.
+  */
+inline librevenge::RVNGInputStream *openFile(const char *const file)
+{
+  std::unique_ptr<libebook::EBOOKMappedFileStream> input(new libebook::EBOOKMappedFileStream(file));
+
+  unsigned long numBytesRead = 0;
+  const unsigned char *const signature = input->read(4, numBytesRead);
+  if ((4 == numBytesRead) && (0 == memcmp(signature, "PK\x03\x04", 4)))
+    return new librevenge::RVNGFileStream(file);
+
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  return input.release();
+}
+
+}
+
+#endif // EBOOK2COMMON_H_INCLUDED
+
+/* vim:set shiftwidth=4 softtabstop=4 noexpandtab: */
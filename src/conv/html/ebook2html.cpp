@@ -16,6 +16,8 @@
 
 #include <libe-book/libe-book.h>
 
+#include "ebook2common.h"
+
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -78,15 +80,16 @@ int main(int argc, char *argv[])
   if (librevenge::RVNGDirectoryStream::isDirectory(file))
     input.reset(new librevenge::RVNGDirectoryStream(file));
   else
-    input.reset(new librevenge::RVNGFileStream(file));
+    input.reset(ebook2common::openFile(file));
 
-  EBOOKDocument::Type type = EBOOKDocument::TYPE_UNKNOWN;
-  EBOOKDocument::Confidence confidence = EBOOKDocument::isSupported(input.get(), &type);
+  EBOOKDocument::Confidence confidence = EBOOKDocument::CONFIDENCE_NONE;
+  std::unique_ptr<EBOOKDocument::Handle, void (*)(EBOOKDocument::Handle *)> handle(EBOOKDocument::open(input.get(), &confidence), EBOOKDocument::close);
 
   if (EBOOKDocument::CONFIDENCE_SUPPORTED_PART == confidence)
   {
+    handle.reset();
     input.reset(librevenge::RVNGDirectoryStream::createForParent(file));
-    confidence = EBOOKDocument::isSupported(input.get(), &type);
+    handle.reset(EBOOKDocument::open(input.get(), &confidence));
   }
 
   if ((EBOOKDocument::CONFIDENCE_EXCELLENT != confidence) && (EBOOKDocument::CONFIDENCE_WEAK != confidence))
@@ -98,7 +101,7 @@ int main(int argc, char *argv[])
   librevenge::RVNGString document;
   librevenge::RVNGHTMLTextGenerator documentGenerator(document);
 
-  if (EBOOKDocument::RESULT_OK != EBOOKDocument::parse(input.get(), &documentGenerator, type))
+  if (EBOOKDocument::RESULT_OK != EBOOKDocument::parse(handle.get(), &documentGenerator))
     return 1;
 
   printf("%s", document.cstr());
@@ -16,6 +16,8 @@
 
 #include <libe-book/libe-book.h>
 
+#include "ebook2common.h"
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -81,15 +83,16 @@ int main(int argc, char *argv[])
   if (librevenge::RVNGDirectoryStream::isDirectory(szInputFile))
     input.reset(new librevenge::RVNGDirectoryStream(szInputFile));
   else
-    input.reset(new librevenge::RVNGFileStream(szInputFile));
+    input.reset(ebook2common::openFile(szInputFile));
 
-  EBOOKDocument::Type type = EBOOKDocument::TYPE_UNKNOWN;
-  EBOOKDocument::Confidence confidence = EBOOKDocument::isSupported(input.get(), &type);
+  EBOOKDocument::Confidence confidence = EBOOKDocument::CONFIDENCE_NONE;
+  std::unique_ptr<EBOOKDocument::Handle, void (*)(EBOOKDocument::Handle *)> handle(EBOOKDocument::open(input.get(), &confidence), EBOOKDocument::close);
 
   if (EBOOKDocument::CONFIDENCE_SUPPORTED_PART == confidence)
   {
+    handle.reset();
     input.reset(librevenge::RVNGDirectoryStream::createForParent(szInputFile));
-    confidence = EBOOKDocument::isSupported(input.get(), &type);
+    handle.reset(EBOOKDocument::open(input.get(), &confidence));
   }
 
   if ((EBOOKDocument::CONFIDENCE_EXCELLENT != confidence) && (EBOOKDocument::CONFIDENCE_WEAK != confidence))
@@ -101,7 +104,10 @@ int main(int argc, char *argv[])
   librevenge::RVNGString document;
   librevenge::RVNGTextTextGenerator documentGenerator(document, isInfo);
 
-  if (EBOOKDocument::RESULT_OK != EBOOKDocument::parse(input.get(), &documentGenerator, type))
+  const EBOOKDocument::Result result = isInfo
+                                      ? EBOOKDocument::parseMetadata(handle.get(), &documentGenerator)
+                                      : EBOOKDocument::parse(handle.get(), &documentGenerator);
+  if (EBOOKDocument::RESULT_OK != result)
     return 1;
 
   printf("%s", document.cstr());
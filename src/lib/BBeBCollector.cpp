@@ -11,6 +11,7 @@
 
 #include <librevenge/librevenge.h>
 
+#include "EBOOKOutputElements.h"
 #include "BBeBCollector.h"
 
 using std::string;
@@ -347,6 +348,24 @@ void BBeBCollector::endDocument()
   m_currentAttributes.pop();
 }
 
+void BBeBCollector::startPart(const BBeBCollector &parent)
+{
+  assert(!parent.m_currentAttributes.empty());
+
+  m_bookAttributes = parent.m_bookAttributes;
+  m_textAttributeMap = parent.m_textAttributeMap;
+  m_blockAttributeMap = parent.m_blockAttributeMap;
+  m_pageAttributeMap = parent.m_pageAttributeMap;
+  m_paragraphAttributeMap = parent.m_paragraphAttributeMap;
+  m_dpi = parent.m_dpi;
+  m_currentAttributes.push(parent.m_currentAttributes.top());
+}
+
+void BBeBCollector::collectPart(const EBOOKOutputElements &part)
+{
+  part.write(m_document);
+}
+
 void BBeBCollector::openPage(const unsigned pageAtrID, const BBeBAttributes &attributes)
 {
   openBlock(pageAtrID, attributes, &m_pageAttributeMap);
@@ -403,11 +422,11 @@ void BBeBCollector::closeParagraph()
   closeBlock();
 }
 
-void BBeBCollector::collectText(const std::string &text, const BBeBAttributes &attributes)
+void BBeBCollector::collectText(const char *const text, const BBeBAttributes &attributes)
 {
   openBlock(0, attributes, nullptr);
   m_document->openSpan(makeCharacterProperties(m_currentAttributes.top(), m_dpi));
-  m_document->insertText(librevenge::RVNGString(text.c_str()));
+  m_document->insertText(librevenge::RVNGString(text));
   m_document->closeSpan();
   closeBlock();
 }
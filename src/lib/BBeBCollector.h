@@ -19,6 +19,8 @@
 namespace libebook
 {
 
+class EBOOKOutputElements;
+
 class BBeBCollector
 {
   // -Weffc++
@@ -49,6 +51,21 @@ public:
   void startDocument();
   void endDocument();
 
+  /** Start collecting a part of the document separately.
+    *
+    * The part continues from the current state of @c parent: the
+    * current attributes and the attribute objects collected so far.
+    * Images are not shared, as their data streams cannot be used by
+    * more collectors at once.
+    *
+    * @arg[in] parent the collector of the whole document
+    */
+  void startPart(const BBeBCollector &parent);
+
+  /** Insert a part of the document that has been collected separately.
+    */
+  void collectPart(const EBOOKOutputElements &part);
+
   void openPage(unsigned pageAtrID, const BBeBAttributes &attributes);
   void closePage();
 
@@ -61,7 +78,7 @@ public:
   void openParagraph(unsigned atrID, const BBeBAttributes &attributes);
   void closeParagraph();
 
-  void collectText(const std::string &text, const BBeBAttributes &attributes);
+  void collectText(const char *text, const BBeBAttributes &attributes);
   void insertLineBreak();
 
   void insertImage(unsigned id);
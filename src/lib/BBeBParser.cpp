@@ -8,14 +8,19 @@
  */
 
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "libebook_utils.h"
-#include "EBOOKCharsetConverter.h"
+#include "EBOOKByteCursor.h"
 #include "EBOOKMemoryStream.h"
-#include "EBOOKStreamView.h"
-#include "EBOOKUTF8Stream.h"
+#include "EBOOKOutputElements.h"
+#include "EBOOKRecordingDocument.h"
+#include "EBOOKUTF8Scan.h"
+#include "EBOOKWorkerThreads.h"
 #include "EBOOKZlibStream.h"
 #include "BBeBMetadataParser.h"
 #include "BBeBParser.h"
@@ -216,19 +221,57 @@ class ParserException
 {
 };
 
-const std::string readString(librevenge::RVNGInputStream *const input)
+struct IndexEntryLess
 {
-  const unsigned size = readU16(input);
+  template<typename Entry>
+  bool operator()(const Entry &left, const Entry &right) const
+  {
+    return left.id < right.id;
+  }
 
-  EBOOKStreamView textStrm(input, input->tell(), input->tell() + int(size));
-  EBOOKCharsetConverter utf16("UTF-16LE");
-  EBOOKUTF8Stream utf8Strm(&textStrm, &utf16);
+  template<typename Entry>
+  bool operator()(const Entry &entry, const unsigned id) const
+  {
+    return entry.id < id;
+  }
+};
 
-  std::string text;
-  while (!utf8Strm.isEnd())
-    text.push_back((char) readU8(&utf8Strm));
+struct IndexEntryEqual
+{
+  template<typename Entry>
+  bool operator()(const Entry &left, const Entry &right) const
+  {
+    return left.id == right.id;
+  }
+};
+
+/// A page decoded by a worker thread.
+struct DecodedPage
+{
+  DecodedPage();
+
+  EBOOKOutputElements content;
+  std::exception_ptr error;
+  bool done;
+};
+
+DecodedPage::DecodedPage()
+  : content()
+  , error()
+  , done(false)
+{
+}
 
-  return text;
+/** Read a UTF-16LE string and convert it to UTF-8.
+  *
+  * @return the 0-terminated string, stored in @c buffer
+  */
+const char *readString(EBOOKByteCursor &input, std::vector<char> &buffer)
+{
+  const unsigned size = input.readU16();
+  convertUTF16LEToUTF8(input.readNBytes(size), size, buffer);
+  buffer.push_back(0);
+  return &buffer[0];
 }
 
 }
@@ -248,6 +291,7 @@ struct BBeBHeader
   unsigned dpi;
   unsigned width;
   unsigned tocOID;
+  long length;
 };
 
 BBeBHeader::BBeBHeader()
@@ -262,19 +306,64 @@ BBeBHeader::BBeBHeader()
   , dpi(0)
   , width(0)
   , tocOID(0)
+  , length(0)
 {
 }
 
 BBeBParser::BBeBParser(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document)
   : m_collector(document)
   , m_input(input)
-  , m_header(new BBeBHeader())
-  , m_objectIndex()
+  , m_header()
+  , m_objectIndex(std::make_shared<ObjectIndex_t>())
+  , m_objectStates()
   , m_pageTree(0)
   , m_toc()
+  , m_threadCount(1)
+  , m_content(nullptr)
+  , m_contentLength(0)
+  , m_inputMutex(std::make_shared<std::mutex>())
+  , m_textBuffer()
 {
 }
 
+BBeBParser::BBeBParser(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document, const std::shared_ptr<BBeBHeader> &header)
+  : m_collector(document)
+  , m_input(input)
+  , m_header(header)
+  , m_objectIndex(std::make_shared<ObjectIndex_t>())
+  , m_objectStates()
+  , m_pageTree(0)
+  , m_toc()
+  , m_threadCount(1)
+  , m_content(nullptr)
+  , m_contentLength(0)
+  , m_inputMutex(std::make_shared<std::mutex>())
+  , m_textBuffer()
+{
+}
+
+BBeBParser::BBeBParser(const BBeBParser &parent, librevenge::RVNGTextInterface *const document)
+  : m_collector(document)
+  , m_input(parent.m_input)
+  , m_header(parent.m_header)
+  , m_objectIndex(parent.m_objectIndex)
+  , m_objectStates(parent.m_objectStates)
+  , m_pageTree(parent.m_pageTree)
+  , m_toc(parent.m_toc)
+  , m_threadCount(1)
+  , m_content(parent.m_content)
+  , m_contentLength(parent.m_contentLength)
+  , m_inputMutex(parent.m_inputMutex)
+  , m_textBuffer()
+{
+  // Objects read by the parent so far are read again if needed, so
+  // only keep track of the objects the part is nested in.
+  for (auto &state : m_objectStates)
+    state &= OBJECT_STATE_READING;
+
+  m_collector.startPart(parent.m_collector);
+}
+
 BBeBParser::~BBeBParser()
 {
 }
@@ -284,6 +373,7 @@ bool BBeBParser::parse()
   readHeader();
   readMetadata();
   readThumbnail();
+  readContent();
   readObjectIndex();
 
   if (0 != m_header->tocOID)
@@ -296,6 +386,22 @@ bool BBeBParser::parse()
   return false;
 }
 
+bool BBeBParser::parseMetadata()
+{
+  readHeader();
+  readMetadata();
+
+  m_collector.startDocument();
+  m_collector.endDocument();
+
+  return true;
+}
+
+void BBeBParser::setThreadCount(const unsigned count)
+{
+  m_threadCount = (0 == count) ? 1 : count;
+}
+
 bool BBeBParser::isSupported(librevenge::RVNGInputStream *const input)
 {
   const unsigned char signature[] = { 'L', '\0', 'R', '\0', 'F', '\0' };
@@ -304,56 +410,93 @@ bool BBeBParser::isSupported(librevenge::RVNGInputStream *const input)
   return (sizeof(signature) == readBytes) && std::equal(signature, signature + sizeof(signature), s);
 }
 
-void BBeBParser::readHeader()
+std::shared_ptr<BBeBHeader> BBeBParser::createHeader(librevenge::RVNGInputStream *const input) try
+{
+  std::shared_ptr<BBeBHeader> header;
+
+  seek(input, 0);
+  if (isSupported(input))
+  {
+    seek(input, 0);
+    header.reset(new BBeBHeader());
+    readHeader(input, *header);
+  }
+
+  return header;
+}
+catch (...)
+{
+  return std::shared_ptr<BBeBHeader>();
+}
+
+void BBeBParser::readHeader(librevenge::RVNGInputStream *const input, BBeBHeader &header)
 {
-  skip(m_input, 8);
-  m_header->version = readU16(m_input);
-  m_header->key = readU16(m_input);
-  m_header->rootOID = readU32(m_input);
-  m_header->numberOfObjects = readU64(m_input);
-  m_header->objectIndexOffset = readU64(m_input);
-  skip(m_input, 6);
-  m_header->dpi = readU16(m_input);
-  if (0 == m_header->dpi)
+  skip(input, 8);
+  header.version = readU16(input);
+  header.key = readU16(input);
+  header.rootOID = readU32(input);
+  header.numberOfObjects = readU64(input);
+  header.objectIndexOffset = readU64(input);
+  skip(input, 6);
+  header.dpi = readU16(input);
+  if (0 == header.dpi)
   {
     EBOOK_DEBUG_MSG(("DPI is 0, likely a broken file\n"));
-    m_header->dpi = 1660;
+    header.dpi = 1660;
   }
-  skip(m_input, 2);
-  m_header->width = readU16(m_input);
-  skip(m_input, 24);
-  m_header->tocOID = readU32(m_input);
-  skip(m_input, 4);
-  m_header->xmlCompSize = readU16(m_input);
-
-  if (800 <= m_header->version)
+  skip(input, 2);
+  header.width = readU16(input);
+  skip(input, 24);
+  header.tocOID = readU32(input);
+  skip(input, 4);
+  header.xmlCompSize = readU16(input);
+
+  if (800 <= header.version)
   {
-    const unsigned thumbnailType = readU16(m_input);
+    const unsigned thumbnailType = readU16(input);
     switch (thumbnailType)
     {
     case BBEB_IMAGE_TYPE_JPEG :
     case BBEB_IMAGE_TYPE_PNG :
     case BBEB_IMAGE_TYPE_BMP :
     case BBEB_IMAGE_TYPE_GIF :
-      m_header->thumbnailType = static_cast<BBeBImageType>(thumbnailType);
+      header.thumbnailType = static_cast<BBeBImageType>(thumbnailType);
       break;
     default :
       EBOOK_DEBUG_MSG(("unknown thumbnail type %x\n", thumbnailType));
       break;
     }
-    m_header->thumbnailSize = readU32(m_input);
+    header.thumbnailSize = readU32(input);
+  }
+
+  header.length = input->tell();
+}
+
+void BBeBParser::readHeader()
+{
+  if (bool(m_header))
+  {
+    // the header has been read already, continue after it
+    seek(m_input, (unsigned long) m_header->length);
+  }
+  else
+  {
+    m_header.reset(new BBeBHeader());
+    readHeader(m_input, *m_header);
   }
 }
 
 void BBeBParser::readMetadata()
 {
-  skip(m_input, 4); // uncompressed size?
+  const unsigned size = readU32(m_input); // uncompressed size?
   unsigned const char *const data = readNBytes(m_input, m_header->xmlCompSize);
-  EBOOKMemoryStream memoryStrm(data, m_header->xmlCompSize);
-  EBOOKZlibStream zlibStrm(&memoryStrm);
+  EBOOKMemoryStream memoryStrm(data, m_header->xmlCompSize, EBOOKMemoryStream::DATA_OWNERSHIP_BORROW);
+  EBOOKZlibStream zlibStrm(&memoryStrm, size);
 
   BBeBMetadataParser parser(&zlibStrm);
   parser.parse();
+  if (zlibStrm.hasFailed())
+    throw ParserException();
 
   m_collector.collectMetadata(parser.getMetadata());
 }
@@ -363,59 +506,112 @@ void BBeBParser::readThumbnail()
   // TODO: implement me
 }
 
+void BBeBParser::readContent()
+{
+  m_input->seek(0, librevenge::RVNG_SEEK_SET);
+  m_contentLength = getRemainingLength(m_input);
+  if (0 == m_contentLength)
+    throw ParserException();
+
+  // The objects refer to each other, so the data of an object must stay
+  // valid while other objects are read. That is only guaranteed for
+  // streams that keep the whole content in memory; from other streams
+  // each object is read separately.
+  if (isInMemory(m_input))
+    m_content = readNBytes(m_input, m_contentLength);
+}
+
+EBOOKByteCursor BBeBParser::readContent(const unsigned long offset, const unsigned long length, std::vector<unsigned char> &buffer)
+{
+  if ((offset > m_contentLength) || (length > m_contentLength - offset))
+    throw EndOfStreamException();
+
+  if (m_content)
+    return EBOOKByteCursor(m_content + offset, length);
+
+  if (0 == length)
+    return EBOOKByteCursor();
+
+  {
+    const std::lock_guard<std::mutex> lock(*m_inputMutex);
+    seek(m_input, offset);
+    const unsigned char *const data = readNBytes(m_input, length);
+    buffer.assign(data, data + length);
+  }
+  return EBOOKByteCursor(&buffer[0], length);
+}
+
 void BBeBParser::readObjectIndex()
 {
-  m_input->seek((long) m_header->objectIndexOffset, librevenge::RVNG_SEEK_SET);
+  if (m_header->objectIndexOffset > m_contentLength)
+    throw EndOfStreamException();
+  const auto offset = static_cast<unsigned long>(m_header->objectIndexOffset);
+  if (m_header->numberOfObjects > (m_contentLength - offset) / 16)
+    throw EndOfStreamException();
+
+  std::vector<unsigned char> buffer;
+  EBOOKByteCursor input(readContent(offset, static_cast<unsigned long>(m_header->numberOfObjects) * 16, buffer));
+
+  ObjectIndex_t &index = *m_objectIndex;
+  index.reserve(static_cast<ObjectIndex_t::size_type>(m_header->numberOfObjects));
   for (uint64_t i = m_header->numberOfObjects; 0 != i; --i)
   {
-    unsigned id = readU32(m_input);
     BBeBIndexEntry entry;
-    entry.offset = readU32(m_input);
-    entry.size = readU32(m_input);
-    entry.read = false;
-    entry.reading = false;
-    m_objectIndex.insert(ObjectIndex_t::value_type(id, entry));
-    skip(m_input, 4);
+    entry.id = input.readU32();
+    entry.offset = input.readU32();
+    entry.size = input.readU32();
+    index.push_back(entry);
+    input.skip(4);
   }
+
+  // sort by ID, keeping the first of duplicate entries
+  std::stable_sort(index.begin(), index.end(), IndexEntryLess());
+  index.erase(std::unique(index.begin(), index.end(), IndexEntryEqual()), index.end());
+
+  m_objectStates.assign(index.size(), 0);
 }
 
 void BBeBParser::readObject(const unsigned id, const unsigned type)
 {
-  auto it = m_objectIndex.find(id);
-  if (it == m_objectIndex.end())
+  const BBeBIndexEntry *const found = findObject(id);
+  if (!found)
   {
     EBOOK_DEBUG_MSG(("object with ID %x not found\n", id));
     throw ParserException();
   }
 
-  BBeBIndexEntry &entry = it->second;
-  if (entry.reading)
+  const BBeBIndexEntry &entry = *found;
+  unsigned char &state = m_objectStates[static_cast<std::vector<unsigned char>::size_type>(found - &m_objectIndex->front())];
+  if (state & OBJECT_STATE_READING)
   {
     EBOOK_DEBUG_MSG(("object %x is already being read\n", id));
     throw ParserException();
   }
-  if (entry.read)
+  if (state & OBJECT_STATE_READ)
   {
     EBOOK_DEBUG_MSG(("object %x has already been read\n", id));
   }
 
-  m_input->seek((long) entry.offset, librevenge::RVNG_SEEK_SET);
+  // The object data are valid until the end of reading of the object,
+  // including the objects nested in it.
+  std::vector<unsigned char> buffer;
+  EBOOKByteCursor input(readContent(entry.offset, entry.size, buffer));
 
-  const unsigned startTag = readU16(m_input);
+  const unsigned startTag = input.readU16();
   if (TAG_OBJECT_START != startTag)
   {
     EBOOK_DEBUG_MSG(("reading object %x, but there is no object at the position\n", id));
     throw ParserException();
   }
 
-  const unsigned objectID = readU32(m_input);
+  const unsigned objectID = input.readU32();
   if (id != objectID)
   {
     EBOOK_DEBUG_MSG(("expected object with ID %x, but found %x\n", id, objectID));
     throw ParserException();
   }
 
-  const unsigned objectType = readU16(m_input);
+  const unsigned objectType = input.readU16();
   if ((OBJECT_TYPE_PAGE_TREE > objectType) || (OBJECT_TYPE_TOC < objectType))
   {
     EBOOK_DEBUG_MSG(("object is of unknown type %x\n", objectType));
@@ -427,120 +623,133 @@ void BBeBParser::readObject(const unsigned id, const unsigned type)
     throw ParserException();
   }
 
-  const unsigned char *const data = readNBytes(m_input, entry.size - 10);
-  EBOOKMemoryStream strm(data, entry.size - 10);
+  const unsigned long objectSize = entry.size - 10;
+  EBOOKByteCursor object(input.readNBytes(objectSize), objectSize);
 
-  const unsigned endTag = readU16(m_input);
+  const unsigned endTag = input.readU16();
   if (TAG_OBJECT_END != endTag)
   {
     EBOOK_DEBUG_MSG(("no end tag found at the end of the object\n"));
     throw ParserException();
   }
 
-  entry.reading = true;
+  state |= OBJECT_STATE_READING;
 
   switch (objectType)
   {
   case OBJECT_TYPE_PAGE_TREE :
     m_pageTree = id;
-    readPageTreeObject(&strm);
+    readPageTreeObject(object);
     m_pageTree = 0;
     break;
   case OBJECT_TYPE_PAGE :
-    readPageObject(&strm);
+    readPageObject(object);
     break;
   case OBJECT_TYPE_HEADER :
-    readHeaderObject(&strm);
+    readHeaderObject(object);
     break;
   case OBJECT_TYPE_FOOTER :
-    readFooterObject(&strm);
+    readFooterObject(object);
     break;
   case OBJECT_TYPE_PAGE_ATR :
-    readPageAtrObject(&strm, id);
+    readPageAtrObject(object, id);
     break;
   case OBJECT_TYPE_BLOCK :
-    readBlockObject(&strm, id);
+    readBlockObject(object, id);
     break;
   case OBJECT_TYPE_BLOCK_ATR :
-    readBlockAtrObject(&strm, id);
+    readBlockAtrObject(object, id);
     break;
   case OBJECT_TYPE_MINI_PAGE :
-    readMiniPageObject(&strm);
+    readMiniPageObject(object);
     break;
   case OBJECT_TYPE_BLOCK_LIST :
-    readBlockListObject(&strm);
+    readBlockListObject(object);
     break;
   case OBJECT_TYPE_TEXT :
-    readTextObject(&strm);
+    readTextObject(object);
     break;
   case OBJECT_TYPE_TEXT_ATR :
-    readTextAtrObject(&strm, id);
+    readTextAtrObject(object, id);
     break;
   case OBJECT_TYPE_IMAGE :
-    readImageObject(&strm, id);
+    readImageObject(object, id);
     break;
   case OBJECT_TYPE_CANVAS :
-    readCanvasObject(&strm);
+    readCanvasObject(object);
     break;
   case OBJECT_TYPE_PARAGRAPH_ATR :
-    readParagraphAtrObject(&strm, id);
+    readParagraphAtrObject(object, id);
     break;
   case OBJECT_TYPE_IMAGE_STREAM :
-    readImageStreamObject(&strm, id);
+    readImageStreamObject(object, id);
     break;
   case OBJECT_TYPE_SoftBookORT :
-    readImportObject(&strm);
+    readImportObject(object);
     break;
   case OBJECT_TYPE_BUTTON :
-    readButtonObject(&strm);
+    readButtonObject(object);
     break;
   case OBJECT_TYPE_WINDOW :
-    readWindowObject(&strm);
+    readWindowObject(object);
     break;
   case OBJECT_TYPE_POP_UP_WIN :
-    readPopUpWinObject(&strm);
+    readPopUpWinObject(object);
     break;
   case OBJECT_TYPE_SOUND :
-    readSoundObject(&strm);
+    readSoundObject(object);
     break;
   case OBJECT_TYPE_PLANE_STREAM :
-    readPlaneStreamObject(&strm);
+    readPlaneStreamObject(object);
     break;
   case OBJECT_TYPE_FONT :
-    readFontObject(&strm);
+    readFontObject(object);
     break;
   case OBJECT_TYPE_OBJECT_INFO :
-    readObjectInfoObject(&strm);
+    readObjectInfoObject(object);
     break;
   case OBJECT_TYPE_BOOK_ATR :
-    readBookAtrObject(&strm);
+    readBookAtrObject(object);
     break;
   case OBJECT_TYPE_SSoftBookLE_TEXT :
-    readSimpleTextObject(&strm);
+    readSimpleTextObject(object);
     break;
   case OBJECT_TYPE_TOC :
-    readTOCObject(&strm);
+    readTOCObject(object);
     break;
   default :
     EBOOK_DEBUG_MSG(("unhandled object type %x\n", type));
     break;
   }
 
-  entry.reading = false;
-  entry.read = true;
+  state = OBJECT_STATE_READ;
 }
 
-void BBeBParser::readPageTreeObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readPageTreeObject(EBOOKByteCursor &object)
 {
   bool readAnyPage = false;
-  if (TAG_PAGE_LIST == readU16(object))
+  if (TAG_PAGE_LIST == object.readU16())
   {
-    unsigned count = readU16(object);
-    if (count > getRemainingLength(object) / 4)
-      count = getRemainingLength(object) / 4;
+    unsigned count = object.readU16();
+    if (count > object.getRemainingLength() / 4)
+      count = object.getRemainingLength() / 4;
     readAnyPage = 0 != count;
+
+    std::vector<unsigned> pages;
+    pages.reserve(count);
     for (unsigned i = 0; i != count; ++i)
-      readObject(readU32(object), OBJECT_TYPE_PAGE);
+      pages.push_back(object.readU32());
+
+    const unsigned threadCount = std::min(m_threadCount, count);
+    if (1 < threadCount)
+    {
+      readPagesInParallel(pages, threadCount);
+    }
+    else
+    {
+      for (std::vector<unsigned>::const_iterator it = pages.begin(); pages.end() != it; ++it)
+        readObject(*it, OBJECT_TYPE_PAGE);
+    }
   }
 
   if (!readAnyPage)
@@ -550,35 +759,118 @@ void BBeBParser::readPageTreeObject(librevenge::RVNGInputStream *const object)
   }
 }
 
-void BBeBParser::readPageObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readPagesInParallel(const std::vector<unsigned> &pages, const unsigned threadCount)
+{
+  // Pages are decoded by worker threads, each by its own parser, and
+  // their content is recorded. The recorded pages are then inserted
+  // into the document in the original order. The workers can only get
+  // a limited number of pages ahead, so the whole document is not kept
+  // in memory.
+  const std::vector<unsigned>::size_type window = 4 * threadCount;
+
+  std::vector<std::unique_ptr<DecodedPage> > decoded(pages.size());
+  for (auto &page : decoded)
+    page.reset(new DecodedPage());
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<unsigned>::size_type next = 0;
+  std::vector<unsigned>::size_type inserted = 0;
+  bool stopped = false;
+
+  const auto decode = [&]()
+  {
+    while (true)
+    {
+      std::vector<unsigned>::size_type current = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]()
+        {
+          return stopped || (pages.size() == next) || (inserted + window > next);
+        });
+        if (stopped || (pages.size() == next))
+          return;
+        current = next++;
+      }
+
+      DecodedPage &page = *decoded[current];
+      try
+      {
+        EBOOKRecordingDocument document(page.content);
+        BBeBParser parser(*this, &document);
+        parser.readObject(pages[current], OBJECT_TYPE_PAGE);
+      }
+      catch (...)
+      {
+        page.error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        page.done = true;
+      }
+      changed.notify_all();
+    }
+  };
+
+  EBOOKWorkerThreads workers(mutex, changed, stopped);
+  for (unsigned i = 0; threadCount != i; ++i)
+    workers.start(decode);
+
+  for (std::vector<unsigned>::size_type i = 0; pages.size() != i; ++i)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&]()
+      {
+        return decoded[i]->done;
+      });
+    }
+
+    // insert even a partial page, like the serial parse does
+    m_collector.collectPart(decoded[i]->content);
+    if (decoded[i]->error)
+      std::rethrow_exception(decoded[i]->error);
+    decoded[i].reset();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++inserted;
+    }
+    changed.notify_all();
+  }
+}
+
+void BBeBParser::readPageObject(EBOOKByteCursor &object)
 {
   unsigned pageAtrID = 0;
   BBeBAttributes attributes;
   unsigned streamFlags = 0;
   unsigned streamSize = 0;
-  std::unique_ptr<EBOOKMemoryStream> strm;
+  boost::optional<EBOOKByteCursor> strm;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     switch (tag)
     {
     case TAG_LINK :
-      pageAtrID = readU32(object);
+      pageAtrID = object.readU32();
       // It is possible that pages can share attributes. So avoid
       // reading the same Page Atr object twice.
       if (!isObjectRead(pageAtrID))
         readObject(pageAtrID, OBJECT_TYPE_PAGE_ATR);
       break;
     case TAG_PARENT_PAGE_TREE :
-      if (readU32(object) != m_pageTree)
+      if (object.readU32() != m_pageTree)
       {
         EBOOK_DEBUG_MSG(("page is not belonging to the current page tree\n"));
         throw ParserException();
       }
       break;
     case TAG_STREAM_FLAGS :
-      streamFlags = readU16(object);
+      streamFlags = object.readU16();
       if (streamFlags != 0)
       {
         EBOOK_DEBUG_MSG(("page stream with weird flags, giving up\n"));
@@ -586,15 +878,15 @@ void BBeBParser::readPageObject(librevenge::RVNGInputStream *const object)
       }
       break;
     case TAG_STREAM_SIZE :
-      streamSize = readU32(object);
-      if (streamSize > getRemainingLength(object))
-        streamSize = getRemainingLength(object);
+      streamSize = object.readU32();
+      if (streamSize > object.getRemainingLength())
+        streamSize = object.getRemainingLength();
       break;
     case TAG_STREAM_START :
     {
-      const unsigned char *streamData = readNBytes(object, streamSize);
-      strm.reset(new EBOOKMemoryStream(streamData, streamSize));
-      if (TAG_STREAM_END != readU16(object))
+      const unsigned char *streamData = object.readNBytes(streamSize);
+      strm = EBOOKByteCursor(streamData, streamSize);
+      if (TAG_STREAM_END != object.readU16())
       {
         EBOOK_DEBUG_MSG(("Stream does not end by Stream End tag\n"));
         throw ParserException();
@@ -618,37 +910,37 @@ void BBeBParser::readPageObject(librevenge::RVNGInputStream *const object)
 
   while (!strm->isEnd())
   {
-    const unsigned tag = readU16(strm.get());
+    const unsigned tag = strm->readU16();
     if (TAG_LINK == tag)
-      readObject(readU32(strm.get())); // this might be a block or a canvas
+      readObject(strm->readU32()); // this might be a block or a canvas
     else
-      skipUnhandledTag(tag, strm.get(), "Page Stream");
+      skipUnhandledTag(tag, *strm, "Page Stream");
   }
 
   m_collector.closePage();
 }
 
-void BBeBParser::readFooterObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readFooterObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Footer is not supported yet\n"));
 }
 
-void BBeBParser::readHeaderObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readHeaderObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Header is not supported yet\n"));
 }
 
-void BBeBParser::readPageAtrObject(librevenge::RVNGInputStream *const object, const unsigned id)
+void BBeBParser::readPageAtrObject(EBOOKByteCursor &object, const unsigned id)
 {
   BBeBAttributes attributes;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     if (!readAttribute(tag, object, attributes))
       skipUnhandledTag(tag, object, "Page Atr");
   }
@@ -656,38 +948,38 @@ void BBeBParser::readPageAtrObject(librevenge::RVNGInputStream *const object, co
   m_collector.collectPageAttributes(id, attributes);
 }
 
-void BBeBParser::readBlockObject(librevenge::RVNGInputStream *const object, const unsigned id)
+void BBeBParser::readBlockObject(EBOOKByteCursor &object, const unsigned id)
 {
   unsigned blockAtrID = 0;
   BBeBAttributes attributes;
   unsigned streamFlags = 0;
   unsigned streamSize = 0;
-  std::unique_ptr<EBOOKMemoryStream> strm;
+  boost::optional<EBOOKByteCursor> strm;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     switch (tag)
     {
     case TAG_LINK :
-      blockAtrID = readU32(object);
+      blockAtrID = object.readU32();
       if (!isObjectRead(blockAtrID))
         readObject(blockAtrID, OBJECT_TYPE_BLOCK_ATR);
       break;
     case TAG_STREAM_FLAGS :
-      streamFlags = readU16(object);
+      streamFlags = object.readU16();
       break;
     case TAG_STREAM_SIZE :
-      streamSize = readU32(object);
-      if (streamSize > getRemainingLength(object))
-        streamSize = getRemainingLength(object);
+      streamSize = object.readU32();
+      if (streamSize > object.getRemainingLength())
+        streamSize = object.getRemainingLength();
       break;
     case TAG_STREAM_START :
     {
-      const unsigned char *const streamData = readNBytes(object, streamSize);
+      const unsigned char *const streamData = object.readNBytes(streamSize);
       if (0 == streamFlags)
-        strm.reset(new EBOOKMemoryStream(streamData, streamSize));
-      if (TAG_STREAM_END != readU16(object))
+        strm = EBOOKByteCursor(streamData, streamSize);
+      if (TAG_STREAM_END != object.readU16())
       {
         EBOOK_DEBUG_MSG(("Stream does not end by Stream End tag\n"));
         throw ParserException();
@@ -716,11 +1008,11 @@ void BBeBParser::readBlockObject(librevenge::RVNGInputStream *const object, cons
   {
     while (!strm->isEnd())
     {
-      const unsigned tag = readU16(strm.get());
+      const unsigned tag = strm->readU16();
       if (TAG_LINK == tag)
-        readObject(readU32(strm.get()));
+        readObject(strm->readU32());
       else
-        skipUnhandledTag(tag, strm.get(), "Block Stream");
+        skipUnhandledTag(tag, *strm, "Block Stream");
     }
   }
   else
@@ -732,13 +1024,13 @@ void BBeBParser::readBlockObject(librevenge::RVNGInputStream *const object, cons
   m_collector.closeBlock();
 }
 
-void BBeBParser::readBlockAtrObject(librevenge::RVNGInputStream *const object, const unsigned id)
+void BBeBParser::readBlockAtrObject(EBOOKByteCursor &object, const unsigned id)
 {
   BBeBAttributes attributes;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     if (!readAttribute(tag, object, attributes))
       skipUnhandledTag(tag, object, "Block Atr");
   }
@@ -746,52 +1038,54 @@ void BBeBParser::readBlockAtrObject(librevenge::RVNGInputStream *const object, c
   m_collector.collectBlockAttributes(id, attributes);
 }
 
-void BBeBParser::readMiniPageObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readMiniPageObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Mini Page is not supported yet\n"));
 }
 
-void BBeBParser::readBlockListObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readBlockListObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Block List is not supported yet\n"));
 }
 
-void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readTextObject(EBOOKByteCursor &object)
 {
   unsigned textAtrID = 0;
   BBeBAttributes attributes;
   unsigned streamFlags = 0;
   unsigned streamSize = 0;
-  std::unique_ptr<librevenge::RVNGInputStream> textStrm;
+  std::unique_ptr<librevenge::RVNGInputStream> compressedStrm;
+  std::unique_ptr<EBOOKZlibStream> inflatedStrm; // inflates from compressedStrm on demand
+  boost::optional<EBOOKByteCursor> textStrm;
   unsigned textLength = 0;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     switch (tag)
     {
     case TAG_LINK :
-      textAtrID = readU32(object);
+      textAtrID = object.readU32();
       if (!isObjectRead(textAtrID))
         readObject(textAtrID, OBJECT_TYPE_TEXT_ATR);
       break;
     case TAG_STREAM_FLAGS :
-      streamFlags = readU16(object);
+      streamFlags = object.readU16();
       break;
     case TAG_STREAM_SIZE :
-      streamSize = readU32(object);
+      streamSize = object.readU32();
       break;
     case TAG_STREAM_START :
     {
-      if (streamSize > getRemainingLength(object))
-        streamSize = getRemainingLength(object);
+      if (streamSize > object.getRemainingLength())
+        streamSize = object.getRemainingLength();
       if (STREAM_TYPE_BBEB_TAGS_COMPRESSED == streamFlags)
       {
-        textLength = readU32(object);
+        textLength = object.readU32();
         if (streamSize <= 4)
         {
           EBOOK_DEBUG_MSG(("Compressed stream is too short\n"));
@@ -801,15 +1095,21 @@ void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
       }
       else
         textLength = streamSize;
-      const unsigned char *const streamData = readNBytes(object, streamSize);
+      const unsigned char *const streamData = object.readNBytes(streamSize);
 
       // prepare text stream
       if (STREAM_TYPE_BBEB_TAGS == streamFlags)
-        textStrm.reset(new EBOOKMemoryStream(streamData, streamSize));
+        textStrm = EBOOKByteCursor(streamData, streamSize);
       else if (STREAM_TYPE_BBEB_TAGS_COMPRESSED == streamFlags)
       {
-        EBOOKMemoryStream strm(streamData, streamSize);
-        textStrm.reset(new EBOOKZlibStream(&strm));
+        compressedStrm.reset(new EBOOKMemoryStream(streamData, streamSize, EBOOKMemoryStream::DATA_OWNERSHIP_BORROW));
+        inflatedStrm.reset(new EBOOKZlibStream(compressedStrm.get(), textLength));
+        textStrm = EBOOKByteCursor(inflatedStrm.get());
+        if (inflatedStrm->hasFailed())
+        {
+          EBOOK_DEBUG_MSG(("Text stream is damaged\n"));
+          throw ParserException();
+        }
       }
       else
       {
@@ -817,7 +1117,7 @@ void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
         throw ParserException();
       }
 
-      if (TAG_STREAM_END != readU16(object))
+      if (TAG_STREAM_END != object.readU16())
       {
         EBOOK_DEBUG_MSG(("Stream does not end by Stream End tag\n"));
         throw ParserException();
@@ -841,7 +1141,7 @@ void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
 
     while (!textStrm->isEnd())
     {
-      const unsigned tag = readU16(textStrm.get());
+      const unsigned tag = textStrm->readU16();
 
       switch (tag)
       {
@@ -849,7 +1149,7 @@ void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
       {
         // NOTE: I am not quite sure the argument is an object ID.
         // But it makes sense.
-        const unsigned paragraphAtrID = readU32(textStrm.get());
+        const unsigned paragraphAtrID = textStrm->readU32();
         if ((0 != paragraphAtrID) && !isObjectRead(paragraphAtrID))
           readObject(paragraphAtrID, OBJECT_TYPE_PARAGRAPH_ATR);
         m_collector.openParagraph(paragraphAtrID, attributes);
@@ -869,8 +1169,7 @@ void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
         break;
       case TAG_TEXT_SIZE :
       {
-        const std::string &text = readString(textStrm.get());
-        m_collector.collectText(text, textAttributes);
+        m_collector.collectText(readString(*textStrm, m_textBuffer), textAttributes);
       }
       break;
       case TAG_EOL :
@@ -879,17 +1178,17 @@ void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
         break;
       case TAG_KOMA_PLOT :
       {
-        skip(textStrm.get(), 4);
-        const unsigned imageID = readU32(textStrm.get());
-        skip(textStrm.get(), 4);
+        textStrm->skip(4);
+        const unsigned imageID = textStrm->readU32();
+        textStrm->skip(4);
         if (!isObjectRead(imageID))
           readObject(imageID, OBJECT_TYPE_IMAGE);
         m_collector.insertImage(imageID);
       }
       break;
       default :
-        if (!readAttribute(tag, textStrm.get(), textAttributes))
-          skipUnhandledTag(tag, textStrm.get(), "Text Stream");
+        if (!readAttribute(tag, *textStrm, textAttributes))
+          skipUnhandledTag(tag, *textStrm, "Text Stream");
       }
     }
 
@@ -903,13 +1202,13 @@ void BBeBParser::readTextObject(librevenge::RVNGInputStream *const object)
   }
 }
 
-void BBeBParser::readTextAtrObject(librevenge::RVNGInputStream *const object, const unsigned id)
+void BBeBParser::readTextAtrObject(EBOOKByteCursor &object, const unsigned id)
 {
   BBeBAttributes attributes;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     if (!readAttribute(tag, object, attributes))
       skipUnhandledTag(tag, object, "Text Atr");
   }
@@ -917,29 +1216,29 @@ void BBeBParser::readTextAtrObject(librevenge::RVNGInputStream *const object, co
   m_collector.collectTextAttributes(id, attributes);
 }
 
-void BBeBParser::readImageObject(librevenge::RVNGInputStream *const object, const unsigned id)
+void BBeBParser::readImageObject(EBOOKByteCursor &object, const unsigned id)
 {
   unsigned width = 0;
   unsigned height = 0;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
 
     switch (tag)
     {
     case TAG_IMAGE_CROP_RECT :
-      skip(object, 8);
+      object.skip(8);
       break;
     case TAG_IMAGE_SIZE :
     {
-      width = readU16(object);
-      height = readU16(object);
+      width = object.readU16();
+      height = object.readU16();
       break;
     }
     case TAG_IMAGE_STREAM :
     {
-      const unsigned image = readU32(object);
+      const unsigned image = object.readU32();
       if (!isObjectRead(image))
         readObject(image, OBJECT_TYPE_IMAGE_STREAM);
       m_collector.collectImage(id, image, width, height);
@@ -952,20 +1251,20 @@ void BBeBParser::readImageObject(librevenge::RVNGInputStream *const object, cons
   }
 }
 
-void BBeBParser::readCanvasObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readCanvasObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Canvas is not supported yet\n"));
 }
 
-void BBeBParser::readParagraphAtrObject(librevenge::RVNGInputStream *const object, const unsigned id)
+void BBeBParser::readParagraphAtrObject(EBOOKByteCursor &object, const unsigned id)
 {
   BBeBAttributes attributes;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     if (!readAttribute(tag, object, attributes))
       skipUnhandledTag(tag, object, "Paragraph Atr");
   }
@@ -973,29 +1272,29 @@ void BBeBParser::readParagraphAtrObject(librevenge::RVNGInputStream *const objec
   m_collector.collectParagraphAttributes(id, attributes);
 }
 
-void BBeBParser::readImageStreamObject(librevenge::RVNGInputStream *const object, const unsigned id)
+void BBeBParser::readImageStreamObject(EBOOKByteCursor &object, const unsigned id)
 {
   unsigned streamType = 0;
   unsigned streamSize = 0;
   RVNGInputStreamPtr_t image;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
 
     switch (tag)
     {
     case TAG_STREAM_FLAGS :
-      streamType = readU16(object);
+      streamType = object.readU16();
       break;
     case TAG_STREAM_SIZE :
-      streamSize = readU16(object);
-      if (streamSize > getRemainingLength(object))
-        streamSize = getRemainingLength(object);
+      streamSize = object.readU16();
+      if (streamSize > object.getRemainingLength())
+        streamSize = object.getRemainingLength();
       break;
     case TAG_STREAM_START :
     {
-      const unsigned char *const streamData = readNBytes(object, streamSize);
+      const unsigned char *const streamData = object.readNBytes(streamSize);
 
       switch (streamType)
       {
@@ -1010,7 +1309,7 @@ void BBeBParser::readImageStreamObject(librevenge::RVNGInputStream *const object
         throw ParserException();
       }
 
-      if (TAG_STREAM_END != readU16(object))
+      if (TAG_STREAM_END != object.readU16())
       {
         EBOOK_DEBUG_MSG(("Stream does not end by Stream End tag\n"));
         throw ParserException();
@@ -1031,74 +1330,74 @@ void BBeBParser::readImageStreamObject(librevenge::RVNGInputStream *const object
   m_collector.collectImageData(id, static_cast<BBeBImageType>(streamType), image);
 }
 
-void BBeBParser::readImportObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readImportObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Import is not supported yet\n"));
 }
 
-void BBeBParser::readButtonObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readButtonObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Button is not supported yet\n"));
 }
 
-void BBeBParser::readWindowObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readWindowObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Window is not supported yet\n"));
 }
 
-void BBeBParser::readPopUpWinObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readPopUpWinObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Pop Up Win is not supported yet\n"));
 }
 
-void BBeBParser::readSoundObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readSoundObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Sound is not supported yet\n"));
 }
 
-void BBeBParser::readPlaneStreamObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readPlaneStreamObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Plane Stream is not supported yet\n"));
 }
 
-void BBeBParser::readFontObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readFontObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Font is not supported yet\n"));
 }
 
-void BBeBParser::readObjectInfoObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readObjectInfoObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Object Info is not supported yet\n"));
 }
 
-void BBeBParser::readBookAtrObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readBookAtrObject(EBOOKByteCursor &object)
 {
   BBeBAttributes attributes;
   unsigned pageTree = 0;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     switch (tag)
     {
     case TAG_CHILD_PAGE_TREE :
-      pageTree = readU32(object);
+      pageTree = object.readU32();
       break;
     default :
       if (!readAttribute(tag, object, attributes))
@@ -1116,42 +1415,42 @@ void BBeBParser::readBookAtrObject(librevenge::RVNGInputStream *const object)
   readObject(pageTree, OBJECT_TYPE_PAGE_TREE);
 }
 
-void BBeBParser::readSimpleTextObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readSimpleTextObject(EBOOKByteCursor &object)
 {
   // TODO: implement me
   (void) object;
   EBOOK_DEBUG_MSG(("object type Simple Text is not supported yet\n"));
 }
 
-void BBeBParser::readTOCObject(librevenge::RVNGInputStream *const object)
+void BBeBParser::readTOCObject(EBOOKByteCursor &object)
 {
   unsigned streamFlags = 0;
   unsigned streamSize = 0;
-  std::unique_ptr<EBOOKMemoryStream> data;
+  boost::optional<EBOOKByteCursor> data;
 
-  while (!object->isEnd())
+  while (!object.isEnd())
   {
-    const unsigned tag = readU16(object);
+    const unsigned tag = object.readU16();
     switch (tag)
     {
     case TAG_STREAM_FLAGS :
-      streamFlags = readU16(object);
+      streamFlags = object.readU16();
       if (STREAM_TYPE_BBEB_TOC != streamFlags)
       {
         EBOOK_DEBUG_MSG(("unexpected ToC stream type %x\n", streamFlags));
       }
       break;
     case TAG_STREAM_SIZE :
-      streamSize = readU32(object);
-      if (streamSize > getRemainingLength(object))
-        streamSize = getRemainingLength(object);
+      streamSize = object.readU32();
+      if (streamSize > object.getRemainingLength())
+        streamSize = object.getRemainingLength();
       break;
     case TAG_STREAM_START :
       if (STREAM_TYPE_BBEB_TOC == streamFlags)
       {
-        const unsigned char *const streamData = readNBytes(object, streamSize);
-        data.reset(new EBOOKMemoryStream(streamData, streamSize));
-        if (TAG_STREAM_END != readU16(object))
+        const unsigned char *const streamData = object.readNBytes(streamSize);
+        data = EBOOKByteCursor(streamData, streamSize);
+        if (TAG_STREAM_END != object.readU16())
         {
           EBOOK_DEBUG_MSG(("Stream does not end by Stream End tag\n"));
           throw ParserException();
@@ -1159,7 +1458,7 @@ void BBeBParser::readTOCObject(librevenge::RVNGInputStream *const object)
       }
       else
       {
-        skip(object, streamSize);
+        object.skip(streamSize);
       }
       break;
     default :
@@ -1169,27 +1468,27 @@ void BBeBParser::readTOCObject(librevenge::RVNGInputStream *const object)
   }
 
   if (bool(data))
-    readToCStream(data.get());
+    readToCStream(get(data));
 }
 
-void BBeBParser::readToCStream(librevenge::RVNGInputStream *const input)
+void BBeBParser::readToCStream(EBOOKByteCursor &input)
 {
-  unsigned count = readU32(input);
-  if (count > getRemainingLength(input) / 4)
-    count = getRemainingLength(input) / 4;
+  unsigned count = input.readU32();
+  if (count > input.getRemainingLength() / 4)
+    count = input.getRemainingLength() / 4;
   std::vector<unsigned> offsets;
 
   offsets.reserve(count);
   for (unsigned i = 0; count != i; ++i)
-    offsets.push_back(readU32(input));
+    offsets.push_back(input.readU32());
 
-  const long start = input->tell();
+  const unsigned long start = input.tell();
   m_toc.reserve(count);
   for (std::vector<unsigned>::const_iterator it = offsets.begin(); offsets.end() != it; ++it)
   {
-    seek(input, (unsigned long)(start + int(*it) + 4));
-    const unsigned oid = readU32(input);
-    if (m_objectIndex.end() != m_objectIndex.find(oid))
+    input.seek(start + *it + 4);
+    const unsigned oid = input.readU32();
+    if (findObject(oid))
     {
       m_toc.push_back(oid);
     }
@@ -1202,71 +1501,71 @@ void BBeBParser::readToCStream(librevenge::RVNGInputStream *const input)
   std::sort(m_toc.begin(), m_toc.end());
 }
 
-bool BBeBParser::readAttribute(const unsigned tag, librevenge::RVNGInputStream *const input, BBeBAttributes &attributes)
+bool BBeBParser::readAttribute(const unsigned tag, EBOOKByteCursor &input, BBeBAttributes &attributes)
 {
   bool handled = true;
 
   switch (tag)
   {
   case TAG_FONT_SIZE :
-    attributes.fontSize = readU16(input);
+    attributes.fontSize = input.readU16();
     break;
   case TAG_FONT_WIDTH :
-    attributes.fontWidth = readU16(input);
+    attributes.fontWidth = input.readU16();
     break;
   case TAG_FONT_ESCAPEMENT :
-    attributes.fontEscapement = readU16(input);
+    attributes.fontEscapement = input.readU16();
     break;
   case TAG_FONT_ORIENTATION :
-    attributes.fontOrientation = readU16(input);
+    attributes.fontOrientation = input.readU16();
     break;
   case TAG_FONT_WEIGHT :
-    attributes.fontWeight = readU16(input);
+    attributes.fontWeight = input.readU16();
     break;
   case TAG_FONT_FACENAME :
-    attributes.fontFacename = readString(input);
+    attributes.fontFacename = std::string(readString(input, m_textBuffer));
     break;
   case TAG_TEXT_COLOR :
-    attributes.textColor = BBeBColor(readU32(input));
+    attributes.textColor = BBeBColor(input.readU32());
     break;
   case TAG_TEXT_BG_COLOR :
-    attributes.textBgColor = BBeBColor(readU32(input));
+    attributes.textBgColor = BBeBColor(input.readU32());
     break;
   case TAG_WORD_SPACE :
-    attributes.wordSpace = readU16(input);
+    attributes.wordSpace = input.readU16();
     break;
   case TAG_LETTER_SPACE :
-    attributes.letterSpace = readU16(input);
+    attributes.letterSpace = input.readU16();
     break;
   case TAG_BASE_LINE_SKIP :
-    attributes.baseLineSkip = readU16(input);
+    attributes.baseLineSkip = input.readU16();
     break;
   case TAG_LINE_SPACE :
-    attributes.lineSpace = readU16(input);
+    attributes.lineSpace = input.readU16();
     break;
   case TAG_PAR_INDENT :
-    attributes.parIndent = readU16(input);
+    attributes.parIndent = input.readU16();
     break;
   case TAG_PAR_SKIP :
-    attributes.parSkip = readU16(input);
+    attributes.parSkip = input.readU16();
     break;
   case TAG_PAGE_HEIGHT :
   case TAG_BLOCK_HEIGHT :
   case TAG_MINI_PAGE_HEIGHT :
   case TAG_CANVAS_HEIGHT :
-    attributes.height = readU16(input);
+    attributes.height = input.readU16();
     break;
   case TAG_PAGE_WIDTH :
   case TAG_BLOCK_WIDTH :
   case TAG_MINI_PAGE_WIDTH :
   case TAG_CANVAS_WIDTH :
-    attributes.width = readU16(input);
+    attributes.width = input.readU16();
     break;
   case TAG_LOCATION_X :
-    attributes.locationX = readU16(input);
+    attributes.locationX = input.readU16();
     break;
   case TAG_LOCATION_Y :
-    attributes.locationY = readU16(input);
+    attributes.locationY = input.readU16();
     break;
   case TAG_BEGIN_ITALIC :
     attributes.italic = true;
@@ -1294,7 +1593,7 @@ bool BBeBParser::readAttribute(const unsigned tag, librevenge::RVNGInputStream *
     break;
   case TAG_EMPTY_LINE_POSITION :
   {
-    const unsigned position = readU16(input);
+    const unsigned position = input.readU16();
     if (attributes.emptyLine)
     {
       switch (position)
@@ -1318,7 +1617,7 @@ bool BBeBParser::readAttribute(const unsigned tag, librevenge::RVNGInputStream *
   }
   case TAG_EMPTY_LINE_MODE :
   {
-    const unsigned mode = readU16(input);
+    const unsigned mode = input.readU16();
     if (attributes.emptyLine)
     {
       switch (mode)
@@ -1351,7 +1650,7 @@ bool BBeBParser::readAttribute(const unsigned tag, librevenge::RVNGInputStream *
   }
   case TAG_ALIGN :
   {
-    const unsigned align = readU16(input);
+    const unsigned align = input.readU16();
     switch (align)
     {
     case 0x1 :
@@ -1370,16 +1669,16 @@ bool BBeBParser::readAttribute(const unsigned tag, librevenge::RVNGInputStream *
     break;
   }
   case TAG_TOP_SKIP :
-    attributes.topSkip = readU16(input);
+    attributes.topSkip = input.readU16();
     break;
   case TAG_TOP_MARGIN :
-    attributes.topMargin = readU16(input);
+    attributes.topMargin = input.readU16();
     break;
   case TAG_ODD_SIDE_MARGIN :
-    attributes.oddSideMargin = readU16(input);
+    attributes.oddSideMargin = input.readU16();
     break;
   case TAG_EVEN_SIDE_MARGIN :
-    attributes.evenSideMargin = readU16(input);
+    attributes.evenSideMargin = input.readU16();
     break;
   default :
     handled = false;
@@ -1389,7 +1688,7 @@ bool BBeBParser::readAttribute(const unsigned tag, librevenge::RVNGInputStream *
   return handled;
 }
 
-void BBeBParser::skipUnhandledTag(const unsigned tag, librevenge::RVNGInputStream *const input, const char *const objectType)
+void BBeBParser::skipUnhandledTag(const unsigned tag, EBOOKByteCursor &input, const char *const objectType)
 {
   switch (tag)
   {
@@ -1511,7 +1810,7 @@ void BBeBParser::skipUnhandledTag(const unsigned tag, librevenge::RVNGInputStrea
   case TAG_CHAR_SPACE :
   case TAG_LINE_WIDTH :
   case TAG_LINE_MODE :
-    skip(input, 2);
+    input.skip(2);
     break;
 
   case TAG_OBJECT_INFO_LINK :
@@ -1543,7 +1842,7 @@ void BBeBParser::skipUnhandledTag(const unsigned tag, librevenge::RVNGInputStrea
   case TAG_LINE_TO :
   case TAG_DRAW_BOX :
   case TAG_DRAW_ELLIPSE :
-    skip(input, 4);
+    input.skip(4);
     break;
 
   case TAG_OBJECT_START :
@@ -1551,34 +1850,34 @@ void BBeBParser::skipUnhandledTag(const unsigned tag, librevenge::RVNGInputStrea
   // fall-through intended
   case TAG_F529 :
   case TAG_F5F9 :
-    skip(input, 6);
+    input.skip(6);
     break;
 
   case TAG_PUT_SOUND :
   case TAG_IMAGE_CROP_RECT :
   case TAG_JUMP_TO :
   case TAG_KOMA_PLOT_TEXT :
-    skip(input, 8);
+    input.skip(8);
     break;
 
   case TAG_RULED_LINE :
-    skip(input, 10);
+    input.skip(10);
     break;
 
   case TAG_F54E :
   case TAG_KOMA_PLOT :
-    skip(input, 12);
+    input.skip(12);
     break;
 
   case TAG_MOVE_OBJ :
-    skip(input, 14);
+    input.skip(14);
     break;
 
   case TAG_CONTAINED_OBJECTS_LIST :
   case TAG_PAGE_LIST :
   {
-    unsigned count = readU16(input);
-    skip(input, count * 4);
+    unsigned count = input.readU16();
+    input.skip(count * 4);
   }
   break;
   case TAG_F50D :
@@ -1595,10 +1894,10 @@ void BBeBParser::skipUnhandledTag(const unsigned tag, librevenge::RVNGInputStrea
   {
     // try to find the next tag
     unsigned n = 1;
-    while (!input->isEnd() && ((0xf5 != readU8(input)) || (2 <= n)))
+    while (!input.isEnd() && ((0xf5 != input.readU8()) || (2 <= n)))
       ++n;
-    if (!input->isEnd())
-      input->seek(-2, librevenge::RVNG_SEEK_CUR);
+    if (!input.isEnd())
+      input.seekRelative(-2);
   }
   break;
   default :
@@ -1612,8 +1911,17 @@ void BBeBParser::skipUnhandledTag(const unsigned tag, librevenge::RVNGInputStrea
 
 bool BBeBParser::isObjectRead(const unsigned id) const
 {
-  const ObjectIndex_t::const_iterator it = m_objectIndex.find(id);
-  return (m_objectIndex.end() != it) && it->second.read;
+  const BBeBIndexEntry *const entry = findObject(id);
+  return entry && (m_objectStates[static_cast<std::vector<unsigned char>::size_type>(entry - &m_objectIndex->front())] & OBJECT_STATE_READ);
+}
+
+const BBeBParser::BBeBIndexEntry *BBeBParser::findObject(const unsigned id) const
+{
+  const ObjectIndex_t &index = *m_objectIndex;
+  const ObjectIndex_t::const_iterator it = std::lower_bound(index.begin(), index.end(), id, IndexEntryLess());
+  if ((index.end() != it) && (id == it->id))
+    return &*it;
+  return nullptr;
 }
 
 } // namespace libebook
@@ -11,8 +11,8 @@
 #define BBEBPARSER_H_INCLUDED
 
 #include <vector>
-#include <map>
 #include <memory>
+#include <mutex>
 
 #include "BBeBCollector.h"
 
@@ -20,6 +20,7 @@
 namespace libebook
 {
 
+class EBOOKByteCursor;
 struct BBeBHeader;
 
 class BBeBParser
@@ -61,75 +62,132 @@ class BBeBParser
 
   struct BBeBIndexEntry
   {
+    unsigned id;
     unsigned offset;
     unsigned size;
-    bool reading;
-    bool read;
   };
 
-  typedef std::map<unsigned, BBeBIndexEntry> ObjectIndex_t;
+  /// Index entries sorted by ID.
+  typedef std::vector<BBeBIndexEntry> ObjectIndex_t;
+
+  /// Flags of an object's state.
+  enum ObjectState
+  {
+    OBJECT_STATE_READING = 0x1,
+    OBJECT_STATE_READ = 0x2
+  };
   typedef std::vector<unsigned> ToC_t;
 
 public:
   BBeBParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document);
+  BBeBParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document, const std::shared_ptr<BBeBHeader> &header);
   ~BBeBParser();
 
   bool parse();
 
+  /** Parse only the document metadata.
+    *
+    * The document's objects are not read at all.
+    */
+  bool parseMetadata();
+
+  /** Set the max. number of threads used to decode pages.
+    *
+    * @arg[in] count the number of threads; 0 is treated as 1
+    */
+  void setThreadCount(unsigned count);
+
   static bool isSupported(librevenge::RVNGInputStream *input);
 
+  /** Read the header of a BBeB file.
+    *
+    * @arg[in] input the input stream
+    * @return the header or an empty pointer if the input is not a BBeB
+    *         file
+    */
+  static std::shared_ptr<BBeBHeader> createHeader(librevenge::RVNGInputStream *input);
+
 private:
+  /** Create a parser for a part of the document read by @c parent.
+    *
+    * The new parser shares the input data and the object index with
+    * the parent, but tracks the read objects itself, so it can be used
+    * in another thread.
+    */
+  BBeBParser(const BBeBParser &parent, librevenge::RVNGTextInterface *document);
+
+  static void readHeader(librevenge::RVNGInputStream *input, BBeBHeader &header);
   void readHeader();
   void readMetadata();
   void readThumbnail();
+  void readContent();
   void readObjectIndex();
 
   void readObject(unsigned id, unsigned type = OBJECT_TYPE_UNSPECIFIED);
 
-  void readPageTreeObject(librevenge::RVNGInputStream *object);
-  void readPageObject(librevenge::RVNGInputStream *object);
-  void readFooterObject(librevenge::RVNGInputStream *object);
-  void readHeaderObject(librevenge::RVNGInputStream *object);
-  void readPageAtrObject(librevenge::RVNGInputStream *object, unsigned id);
-  void readBlockObject(librevenge::RVNGInputStream *object, unsigned id);
-  void readBlockAtrObject(librevenge::RVNGInputStream *object, unsigned id);
-  void readMiniPageObject(librevenge::RVNGInputStream *object);
-  void readBlockListObject(librevenge::RVNGInputStream *object);
-  void readTextObject(librevenge::RVNGInputStream *object);
-  void readTextAtrObject(librevenge::RVNGInputStream *object, unsigned id);
-  void readImageObject(librevenge::RVNGInputStream *object, unsigned id);
-  void readCanvasObject(librevenge::RVNGInputStream *object);
-  void readParagraphAtrObject(librevenge::RVNGInputStream *object, unsigned id);
-  void readImageStreamObject(librevenge::RVNGInputStream *object, unsigned id);
-  void readImportObject(librevenge::RVNGInputStream *object);
-  void readButtonObject(librevenge::RVNGInputStream *object);
-  void readWindowObject(librevenge::RVNGInputStream *object);
-  void readPopUpWinObject(librevenge::RVNGInputStream *object);
-  void readSoundObject(librevenge::RVNGInputStream *object);
-  void readPlaneStreamObject(librevenge::RVNGInputStream *object);
-  void readFontObject(librevenge::RVNGInputStream *object);
-  void readObjectInfoObject(librevenge::RVNGInputStream *object);
-  void readBookAtrObject(librevenge::RVNGInputStream *object);
-  void readSimpleTextObject(librevenge::RVNGInputStream *object);
-  void readTOCObject(librevenge::RVNGInputStream *object);
-
-  void readToCStream(librevenge::RVNGInputStream *input);
-
-  bool readAttribute(unsigned tag, librevenge::RVNGInputStream *input, BBeBAttributes &attributes);
-
-  void skipUnhandledTag(unsigned tag, librevenge::RVNGInputStream *input, const char *objectType);
+  /** Get a part of the input.
+    *
+    * If the input is not kept in memory, the part is read into @c buffer.
+    *
+    * @arg[in] offset the offset of the part
+    * @arg[in] length the length of the part
+    * @arg[in] buffer a buffer that must outlive the returned cursor
+    * @return a cursor over the part
+    */
+  EBOOKByteCursor readContent(unsigned long offset, unsigned long length, std::vector<unsigned char> &buffer);
+
+  void readPageTreeObject(EBOOKByteCursor &object);
+  void readPagesInParallel(const std::vector<unsigned> &pages, unsigned threadCount);
+  void readPageObject(EBOOKByteCursor &object);
+  void readFooterObject(EBOOKByteCursor &object);
+  void readHeaderObject(EBOOKByteCursor &object);
+  void readPageAtrObject(EBOOKByteCursor &object, unsigned id);
+  void readBlockObject(EBOOKByteCursor &object, unsigned id);
+  void readBlockAtrObject(EBOOKByteCursor &object, unsigned id);
+  void readMiniPageObject(EBOOKByteCursor &object);
+  void readBlockListObject(EBOOKByteCursor &object);
+  void readTextObject(EBOOKByteCursor &object);
+  void readTextAtrObject(EBOOKByteCursor &object, unsigned id);
+  void readImageObject(EBOOKByteCursor &object, unsigned id);
+  void readCanvasObject(EBOOKByteCursor &object);
+  void readParagraphAtrObject(EBOOKByteCursor &object, unsigned id);
+  void readImageStreamObject(EBOOKByteCursor &object, unsigned id);
+  void readImportObject(EBOOKByteCursor &object);
+  void readButtonObject(EBOOKByteCursor &object);
+  void readWindowObject(EBOOKByteCursor &object);
+  void readPopUpWinObject(EBOOKByteCursor &object);
+  void readSoundObject(EBOOKByteCursor &object);
+  void readPlaneStreamObject(EBOOKByteCursor &object);
+  void readFontObject(EBOOKByteCursor &object);
+  void readObjectInfoObject(EBOOKByteCursor &object);
+  void readBookAtrObject(EBOOKByteCursor &object);
+  void readSimpleTextObject(EBOOKByteCursor &object);
+  void readTOCObject(EBOOKByteCursor &object);
+
+  void readToCStream(EBOOKByteCursor &input);
+
+  bool readAttribute(unsigned tag, EBOOKByteCursor &input, BBeBAttributes &attributes);
+
+  void skipUnhandledTag(unsigned tag, EBOOKByteCursor &input, const char *objectType);
 
   bool isObjectRead(unsigned id) const;
+  const BBeBIndexEntry *findObject(unsigned id) const;
 
   double toInches(unsigned px) const;
 
 private:
   BBeBCollector m_collector;
   librevenge::RVNGInputStream *m_input;
-  std::unique_ptr<BBeBHeader> m_header;
-  ObjectIndex_t m_objectIndex;
+  std::shared_ptr<BBeBHeader> m_header;
+  std::shared_ptr<ObjectIndex_t> m_objectIndex;
+  std::vector<unsigned char> m_objectStates; //< ObjectState flags, in the order of the index
   unsigned m_pageTree;
   ToC_t m_toc;
+  unsigned m_threadCount;
+  const unsigned char *m_content; //< the whole input, if it is kept in memory
+  unsigned long m_contentLength;
+  std::shared_ptr<std::mutex> m_inputMutex; //< guards reading of m_input, which is shared with parsers of parts
+  std::vector<char> m_textBuffer; //< reused buffer for converted strings
 };
 
 } // namespace libebook
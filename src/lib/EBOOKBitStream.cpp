@@ -16,128 +16,118 @@
 namespace libebook
 {
 
-const uint8_t EBOOKBitStream::s_masks[] = { 0x1, 0x3, 0x7, 0xf, 0x1f, 0x3f, 0x7f, 0xff };
-
 EBOOKBitStream::EBOOKBitStream(librevenge::RVNGInputStream *const stream)
-  : m_stream(stream)
-  , m_current(0)
+  : m_begin(nullptr)
+  , m_end(nullptr)
+  , m_current(nullptr)
+  , m_bits(0)
+  , m_available(0)
+{
+  assert(stream);
+
+  const unsigned long length = getRemainingLength(stream);
+  if (0 < length)
+  {
+    m_begin = readNBytes(stream, length);
+    m_end = m_begin + length;
+    m_current = m_begin;
+  }
+}
+
+EBOOKBitStream::EBOOKBitStream(const unsigned char *const data, const unsigned long length)
+  : m_begin(data)
+  , m_end(data + length)
+  , m_current(data)
+  , m_bits(0)
   , m_available(0)
 {
+  assert(data || (0 == length));
 }
 
 uint32_t EBOOKBitStream::read(uint8_t numberOfBits, const bool bigEndian)
 {
   assert(numberOfBits <= 8 * sizeof(uint32_t));
 
+  if (bigEndian || (8 >= numberOfBits))
+  {
+    const uint32_t value = peek(numberOfBits);
+    consume(numberOfBits);
+    return value;
+  }
+
+  uint32_t value = 0;
+  unsigned shift = 0;
+  for (; 8 <= numberOfBits; numberOfBits = uint8_t(numberOfBits - 8), shift += 8)
+    value |= read(8) << shift;
+  if (0 < numberOfBits)
+    value |= read(numberOfBits) << shift;
+
+  return value;
+}
+
+uint32_t EBOOKBitStream::peek(const uint8_t numberOfBits)
+{
+  assert(numberOfBits <= 8 * sizeof(uint32_t));
+
   if (numberOfBits == 0)
     return 0;
 
-  uint8_t p[] = { 0, 0, 0, 0 };
+  if (m_available < numberOfBits)
+    refill();
 
-  if (bigEndian)
-  {
-    int i = (numberOfBits - 1) / 8;
+  // the bits behind the available ones are either 0 or the following
+  // bits of the data
+  return uint32_t(m_bits >> (64 - numberOfBits));
+}
 
-    const uint8_t over = numberOfBits % 8;
-    if (0 < over)
-    {
-      p[i] = readBits(over);
-      numberOfBits = uint8_t(numberOfBits-over);
-      --i;
-    }
-    assert(0 == numberOfBits % 8);
+void EBOOKBitStream::consume(const uint8_t numberOfBits)
+{
+  assert(numberOfBits <= 8 * sizeof(uint32_t));
 
-    while (8 <= numberOfBits)
-    {
-      p[i] = readByte();
-      numberOfBits = uint8_t(numberOfBits-8);
-      --i;
-    }
-    assert(0 == numberOfBits);
-  }
-  else
+  if (m_available < numberOfBits)
   {
-    int i = 0;
-
-    while (8 <= numberOfBits)
-    {
-      p[i] = readByte();
-      numberOfBits = uint8_t(numberOfBits-8);
-      ++i;
-    }
-    assert(8 > numberOfBits);
-
-    if (0 < numberOfBits)
-      p[i] = readBits(numberOfBits);
+    refill();
+    if (m_available < numberOfBits)
+      throw EndOfStreamException();
   }
 
-  return (uint32_t)p[0]|((uint32_t)p[1]<<8)|((uint32_t)p[2]<<16)|((uint32_t)p[3]<<24);
+  m_bits <<= numberOfBits;
+  m_available -= numberOfBits;
 }
 
 bool EBOOKBitStream::isEnd() const
 {
-  return atLastByte() && (0 == m_available);
+  return (m_end == m_current) && (0 == m_available);
 }
 
 bool EBOOKBitStream::atLastByte() const
 {
-  if (m_stream->isEnd())
-    return true;
-
-  const_cast<EBOOKBitStream *>(this)->fill();
-  return m_stream->isEnd();
+  const unsigned long consumed = static_cast<unsigned long>(m_current - m_begin) * 8 - m_available;
+  return consumed / 8 + 1 >= static_cast<unsigned long>(m_end - m_begin);
 }
 
-void EBOOKBitStream::fill()
+void EBOOKBitStream::refill()
 {
-  if (0 == m_available)
+  if (8 <= m_end - m_current)
   {
-    m_current = readU8(m_stream);
-    m_available = 8;
+    uint64_t word = 0;
+    for (int i = 0; i != 8; ++i)
+      word = (word << 8) | m_current[i];
+
+    // The bits that do not fit are taken again by the next refill.
+    m_bits |= word >> m_available;
+    const unsigned bytes = (64 - m_available) / 8;
+    m_current += bytes;
+    m_available += 8 * bytes;
   }
-  assert(m_available > 0);
-}
-
-uint8_t EBOOKBitStream::readByte()
-{
-  return readBits(8);
-}
-
-uint8_t EBOOKBitStream::readBits(uint8_t numberOfBits)
-{
-  assert(numberOfBits <= 8);
-
-  if (numberOfBits == 0)
-    return 0;
-
-  uint8_t value = 0;
-
-  fill();
-
-  if (numberOfBits <= m_available)
-    value = readAvailableBits(numberOfBits);
   else
   {
-    numberOfBits = uint8_t(numberOfBits-m_available);
-    value = readAvailableBits(m_available);
-    fill();
-    value = uint8_t(value<<numberOfBits);
-    value = uint8_t(value|readAvailableBits(numberOfBits));
+    while ((56 >= m_available) && (m_end != m_current))
+    {
+      m_bits |= uint64_t(*m_current++) << (56 - m_available);
+      m_available += 8;
+    }
   }
-
-  return value;
-}
-
-uint8_t EBOOKBitStream::readAvailableBits(const uint8_t numberOfBits)
-{
-  assert(numberOfBits <= m_available);
-
-  uint8_t current = m_current;
-  if (numberOfBits < m_available)
-    current =  uint8_t (current >> (m_available - numberOfBits));
-  m_available = uint8_t(m_available - numberOfBits);
-
-  return s_masks[numberOfBits - 1] & current;
 }
 
 }
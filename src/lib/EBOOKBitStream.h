@@ -16,43 +16,73 @@
 namespace libebook
 {
 
+/** A reader of bits.
+  *
+  * The bits of every byte are read from the highest one. Up to 64 bits
+  * are buffered; the buffer is refilled by whole words from the data.
+  *
+  * Reading past the end throws EndOfStreamException.
+  */
 class EBOOKBitStream
 {
+  // disable copying
+  EBOOKBitStream(const EBOOKBitStream &other);
+  EBOOKBitStream &operator=(const EBOOKBitStream &other);
+
 public:
+  /** Create a bit stream of the rest of a stream.
+    *
+    * The data are taken from the stream at once, like in
+    * EBOOKByteCursor, so they are only valid until the next read from
+    * the stream or until the stream is destroyed.
+    *
+    * @arg[in] stream the input stream. It is positioned at its end
+    *   after the bit stream is created.
+    */
   explicit EBOOKBitStream(librevenge::RVNGInputStream *stream);
+  EBOOKBitStream(const unsigned char *data, unsigned long length);
 
+  /** Read a number.
+    *
+    * @arg[in] numberOfBits the number of bits to read. Has to be less
+    *   than or equal to 32.
+    * @arg[in] bigEndian if true, the first read bit is the highest bit
+    *   of the number. Otherwise the number is read by bytes from the
+    *   lowest one, the remaining bits forming the highest byte.
+    * @return the number
+    */
   uint32_t read(uint8_t numberOfBits, bool bigEndian = false);
 
-  bool isEnd() const;
-  bool atLastByte() const;
-
-private:
-  void fill();
-
-  /** Reads a byte from the stream.
+  /** Get the next bits without consuming them.
+    *
+    * This is meant for table-driven decoders. If there are not enough
+    * bits left, the missing ones are 0.
     *
-    * @return a byte
+    * @arg[in] numberOfBits the number of bits. Has to be less than or
+    *   equal to 32.
+    * @return the bits, the first one being the highest
     */
-  uint8_t readByte();
+  uint32_t peek(uint8_t numberOfBits);
 
-  /** Reads a given amount of bits from the stream.
+  /** Skip bits.
     *
-    * @arg[in] numberOfBits the number of bits to read. Has to be less
-    * than or equal to 8.
-    *
-    * @return a byte containing the bits
+    * @arg[in] numberOfBits the number of bits. Has to be less than or
+    *   equal to 32.
     */
-  uint8_t readBits(uint8_t numberOfBits);
+  void consume(uint8_t numberOfBits);
 
-  uint8_t readAvailableBits(uint8_t numberOfBits);
+  bool isEnd() const;
+  bool atLastByte() const;
 
 private:
-  static const uint8_t s_masks[8];
+  void refill();
 
 private:
-  librevenge::RVNGInputStream *const m_stream;
-  uint8_t m_current;
-  uint8_t m_available;
+  const unsigned char *m_begin;
+  const unsigned char *m_end;
+  const unsigned char *m_current;
+  uint64_t m_bits; //< buffered bits, starting from the highest one
+  unsigned m_available; //< the number of buffered bits
 };
 
 }
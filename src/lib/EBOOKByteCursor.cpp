@@ -0,0 +1,74 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cassert>
+
+#include "EBOOKByteCursor.h"
+
+namespace libebook
+{
+
+EBOOKByteCursor::EBOOKByteCursor()
+  : m_begin(nullptr)
+  , m_end(nullptr)
+  , m_current(nullptr)
+{
+}
+
+EBOOKByteCursor::EBOOKByteCursor(const unsigned char *const data, const unsigned long length)
+  : m_begin(data)
+  , m_end(data + length)
+  , m_current(data)
+{
+  assert(data || (0 == length));
+}
+
+EBOOKByteCursor::EBOOKByteCursor(librevenge::RVNGInputStream *const input)
+  : m_begin(nullptr)
+  , m_end(nullptr)
+  , m_current(nullptr)
+{
+  const unsigned long length = libebook::getRemainingLength(input);
+  if (0 < length)
+  {
+    m_begin = libebook::readNBytes(input, length);
+    m_end = m_begin + length;
+    m_current = m_begin;
+  }
+}
+
+const unsigned char *EBOOKByteCursor::readNBytes(const unsigned long numBytes)
+{
+  const unsigned char *const data = require(numBytes);
+  m_current += numBytes;
+  return data;
+}
+
+void EBOOKByteCursor::skip(const unsigned long numBytes)
+{
+  m_current = require(numBytes) + numBytes;
+}
+
+void EBOOKByteCursor::seek(const unsigned long pos)
+{
+  if (pos > getLength())
+    throw EndOfStreamException();
+  m_current = m_begin + pos;
+}
+
+void EBOOKByteCursor::seekRelative(const long offset)
+{
+  if ((0 > offset) ? (static_cast<unsigned long>(-offset) > tell()) : (static_cast<unsigned long>(offset) > getRemainingLength()))
+    throw EndOfStreamException();
+  m_current += offset;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,142 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef EBOOKBYTECURSOR_H_INCLUDED
+#define EBOOKBYTECURSOR_H_INCLUDED
+
+#include "libebook_utils.h"
+
+namespace libebook
+{
+
+/** Decoding of little endian numbers.
+  */
+struct EBOOKLittleEndian
+{
+  static uint16_t getU16(const unsigned char *const p)
+  {
+    return static_cast<uint16_t>(uint16_t(p[0]) | (uint16_t(p[1]) << 8));
+  }
+
+  static uint32_t getU32(const unsigned char *const p)
+  {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+  }
+};
+
+/** Decoding of big endian numbers.
+  */
+struct EBOOKBigEndian
+{
+  static uint16_t getU16(const unsigned char *const p)
+  {
+    return static_cast<uint16_t>(uint16_t(p[1]) | (uint16_t(p[0]) << 8));
+  }
+
+  static uint32_t getU32(const unsigned char *const p)
+  {
+    return uint32_t(p[3]) | (uint32_t(p[2]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[0]) << 24);
+  }
+};
+
+/** A bounds-checked reader of a contiguous block of memory.
+  *
+  * This is a cheap replacement of readU8() and friends for loops that
+  * read a whole stream or a part of it byte by byte: there are no
+  * virtual calls, only a range check per read. Reading past the end
+  * throws EndOfStreamException, just like with a stream.
+  *
+  * The cursor does not own the data.
+  */
+class EBOOKByteCursor
+{
+public:
+  EBOOKByteCursor();
+  EBOOKByteCursor(const unsigned char *data, unsigned long length);
+
+  /** Create a cursor over the rest of a stream.
+    *
+    * For memory-backed streams (EBOOKMemoryStream, the decompressing
+    * streams, EBOOKStreamView of a memory stream...) this does not copy
+    * anything. The data are only valid until the next read from the
+    * stream or until the stream is destroyed.
+    *
+    * @arg[in] input the input stream. It is positioned at its end after
+    *   the cursor is created.
+    */
+  explicit EBOOKByteCursor(librevenge::RVNGInputStream *input);
+
+  bool isEnd() const
+  {
+    return m_end == m_current;
+  }
+
+  unsigned long tell() const
+  {
+    return static_cast<unsigned long>(m_current - m_begin);
+  }
+
+  unsigned long getLength() const
+  {
+    return static_cast<unsigned long>(m_end - m_begin);
+  }
+
+  unsigned long getRemainingLength() const
+  {
+    return static_cast<unsigned long>(m_end - m_current);
+  }
+
+  uint8_t readU8()
+  {
+    if (m_end == m_current)
+      throw EndOfStreamException();
+    return *m_current++;
+  }
+
+  template<class Endian = EBOOKLittleEndian>
+  uint16_t readU16()
+  {
+    const uint16_t value = Endian::getU16(require(2));
+    m_current += 2;
+    return value;
+  }
+
+  template<class Endian = EBOOKLittleEndian>
+  uint32_t readU32()
+  {
+    const uint32_t value = Endian::getU32(require(4));
+    m_current += 4;
+    return value;
+  }
+
+  const unsigned char *readNBytes(unsigned long numBytes);
+
+  void skip(unsigned long numBytes);
+  void seek(unsigned long pos);
+  void seekRelative(long offset);
+
+private:
+  const unsigned char *require(const unsigned long numBytes) const
+  {
+    if (numBytes > getRemainingLength())
+      throw EndOfStreamException();
+    return m_current;
+  }
+
+private:
+  const unsigned char *m_begin;
+  const unsigned char *m_end;
+  const unsigned char *m_current;
+};
+
+}
+
+#endif // EBOOKBYTECURSOR_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -7,14 +7,20 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <map>
+#include <mutex>
 #include <string>
 
 #include <unicode/ucsdet.h>
 
+#include "libebook_utils.h"
 #include "EBOOKCharsetConverter.h"
+#include "EBOOKUTF8Scan.h"
 
 using std::string;
+using std::vector;
 
 namespace libebook
 {
@@ -26,6 +32,25 @@ class ConverterException
 {
 };
 
+const std::vector<UChar>::size_type PIVOT_SIZE = 1024;
+
+// the max. number of unused converters kept for one encoding
+const vector<UConverter *>::size_type POOL_SIZE = 8;
+
+// input shorter than this gets an output buffer big enough for any
+// likely text; longer input starts with a smaller buffer, which is grown
+// as needed
+const unsigned SHORT_INPUT_LENGTH = 0x10000;
+
+// the size of the start of the text used to guess the encoding
+const unsigned SAMPLE_HEAD_SIZE = 0x4000;
+// the size and number of the parts of the rest of the text that are
+// added to the sample if the guess from the start is not confident
+const unsigned SAMPLE_PART_SIZE = 0x1000;
+const unsigned SAMPLE_PART_COUNT = 12;
+// the confidence that is good enough
+const int32_t SAMPLE_CONFIDENCE = 50;
+
 /** Guess character set of the text.
 
   @param[in] text the text
@@ -65,22 +90,176 @@ bool guessCharacterSet(const char *const text, const unsigned length, string &ch
   return status == U_ZERO_ERROR;
 }
 
+/** Create a sample of a long text.
+
+  @param[in] text the text
+  @param[in] length the length of the text
+  @param[out] sample the sample
+ */
+void makeSample(const char *const text, const unsigned length, vector<char> &sample)
+{
+  assert(SAMPLE_HEAD_SIZE + SAMPLE_PART_COUNT * SAMPLE_PART_SIZE < length);
+
+  sample.reserve(SAMPLE_HEAD_SIZE + SAMPLE_PART_COUNT * SAMPLE_PART_SIZE);
+  sample.assign(text, text + SAMPLE_HEAD_SIZE);
+
+  const unsigned stride = (length - SAMPLE_HEAD_SIZE) / SAMPLE_PART_COUNT;
+  for (unsigned i = 0; SAMPLE_PART_COUNT != i; ++i)
+  {
+    // keep the alignment of multi-byte encodings like UTF-16
+    const unsigned start = (SAMPLE_HEAD_SIZE + i * stride) & ~3u;
+    sample.insert(sample.end(), text + start, text + start + SAMPLE_PART_SIZE);
+  }
+}
+
+/** A process-wide pool of opened ICU converters.
+  *
+  * Opening a converter is expensive, so converters are not closed when
+  * an EBOOKCharsetConverter is destroyed, but kept for reuse. A converter
+  * is reset before it is handed out again.
+  */
+class ConverterPool
+{
+  // disable copying
+  ConverterPool(const ConverterPool &other);
+  ConverterPool &operator=(const ConverterPool &other);
+
+public:
+  ConverterPool();
+  ~ConverterPool();
+
+  static ConverterPool &get();
+
+  UConverter *acquire(const char *encoding, UErrorCode &status);
+  void release(UConverter *converter);
+
+  EBOOKCharsetConverter::CacheStatistics getStatistics();
+
+private:
+  std::mutex m_mutex;
+  std::map<string, string> m_names; //< requested name -> name of the opened converter
+  std::map<string, vector<UConverter *> > m_converters; //< unused converters by name
+  unsigned long m_hits;
+  unsigned long m_misses;
+};
+
+ConverterPool::ConverterPool()
+  : m_mutex()
+  , m_names()
+  , m_converters()
+  , m_hits(0)
+  , m_misses(0)
+{
+}
+
+ConverterPool::~ConverterPool()
+{
+  for (auto &converters : m_converters)
+  {
+    for (auto *converter : converters.second)
+      ucnv_close(converter);
+  }
+}
+
+ConverterPool &ConverterPool::get()
+{
+  static ConverterPool pool;
+  return pool;
+}
+
+UConverter *ConverterPool::acquire(const char *const encoding, UErrorCode &status)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto name = m_names.find(encoding);
+    if (m_names.end() != name)
+    {
+      const auto converters = m_converters.find(name->second);
+      if ((m_converters.end() != converters) && !converters->second.empty())
+      {
+        UConverter *const converter = converters->second.back();
+        converters->second.pop_back();
+        ++m_hits;
+        ucnv_reset(converter);
+        return converter;
+      }
+    }
+    ++m_misses;
+  }
+
+  UConverter *const converter = ucnv_open(encoding, &status);
+  if (status == U_ZERO_ERROR)
+  {
+    UErrorCode nameStatus = U_ZERO_ERROR;
+    const char *const name = ucnv_getName(converter, &nameStatus);
+    if (U_SUCCESS(nameStatus))
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_names[encoding] = name;
+    }
+  }
+  return converter;
+}
+
+void ConverterPool::release(UConverter *const converter)
+{
+  if (!converter)
+    return;
+
+  UErrorCode status = U_ZERO_ERROR;
+  const char *const name = ucnv_getName(converter, &status);
+  if (U_SUCCESS(status))
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    vector<UConverter *> &converters = m_converters[name];
+    if (POOL_SIZE > converters.size())
+    {
+      converters.push_back(converter);
+      return;
+    }
+  }
+
+  ucnv_close(converter);
+}
+
+EBOOKCharsetConverter::CacheStatistics ConverterPool::getStatistics()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  EBOOKCharsetConverter::CacheStatistics statistics;
+  statistics.hits = m_hits;
+  statistics.misses = m_misses;
+  return statistics;
+}
+
+void releaseConverter(UConverter *const converter)
+{
+  ConverterPool::get().release(converter);
+}
+
 }
 
 EBOOKCharsetConverter::EBOOKCharsetConverter(const char *const encoding)
-  : m_converterToUnicode(nullptr, ucnv_close)
-  , m_converterToUTF8(nullptr, ucnv_close)
+  : m_converterToUnicode(nullptr, releaseConverter)
+  , m_converterToUTF8(nullptr, releaseConverter)
+  , m_pivot()
+  , m_pivotSource(nullptr)
+  , m_pivotTarget(nullptr)
+  , m_guessSampleSize(0)
+  , m_guessConfidence(0)
+  , m_passThrough(PASS_THROUGH_NONE)
 {
   UErrorCode status = U_ZERO_ERROR;
-  m_converterToUTF8.reset(ucnv_open("utf-8", &status));
+  m_converterToUTF8.reset(ConverterPool::get().acquire("utf-8", status));
   if (status != U_ZERO_ERROR)
     throw ConverterException();
 
   if (encoding)
   {
-    m_converterToUnicode.reset(ucnv_open(encoding, &status));
+    m_converterToUnicode.reset(ConverterPool::get().acquire(encoding, status));
     if (status != U_ZERO_ERROR)
       throw ConverterException();
+    updatePassThrough();
   }
 }
 
@@ -95,49 +274,259 @@ bool EBOOKCharsetConverter::guessEncoding(const char *const in, const unsigned l
 
   string charset;
   int32_t confidence = 0;
-  if (guessCharacterSet(in, length, charset, confidence))
+  unsigned sampleSize = std::min(length, SAMPLE_HEAD_SIZE);
+  bool guessed = false;
+
+  // Valid UTF-8 with non-ASCII characters is very unlikely to be
+  // anything else. Pure ASCII is left to the detector, as the caller
+  // might have passed only the start of the text.
+  const unsigned long nonASCII = findNonASCII(in, length);
+  if ((length != nonASCII) && isValidUTF8(in + nonASCII, length - nonASCII))
+  {
+    charset = "UTF-8";
+    confidence = 100;
+    sampleSize = length;
+    guessed = true;
+  }
+  else
+  {
+    guessed = guessCharacterSet(in, sampleSize, charset, confidence);
+  }
+
+  if ((sampleSize < length) && (!guessed || (SAMPLE_CONFIDENCE > confidence)))
+  {
+    vector<char> sample;
+    const char *sampleData = in;
+    if (SAMPLE_HEAD_SIZE + SAMPLE_PART_COUNT * SAMPLE_PART_SIZE < length)
+    {
+      makeSample(in, length, sample);
+      sampleData = &sample[0];
+      sampleSize = static_cast<unsigned>(sample.size());
+    }
+    else
+    {
+      sampleSize = length;
+    }
+
+    string sampleCharset;
+    int32_t sampleConfidence = 0;
+    if (guessCharacterSet(sampleData, sampleSize, sampleCharset, sampleConfidence))
+    {
+      charset = sampleCharset;
+      confidence = sampleConfidence;
+      guessed = true;
+    }
+  }
+
+  m_guessSampleSize = sampleSize;
+  m_guessConfidence = confidence;
+
+  if (guessed)
   {
+    EBOOK_DEBUG_MSG(("guessed encoding %s with confidence %d from %u of %u bytes\n", charset.c_str(), int(confidence), sampleSize, length));
+
     UErrorCode status = U_ZERO_ERROR;
-    m_converterToUnicode.reset(ucnv_open(charset.c_str(), &status));
+    m_converterToUnicode.reset(ConverterPool::get().acquire(charset.c_str(), status));
     if (status == U_ZERO_ERROR)
+    {
+      updatePassThrough();
       return true;
+    }
   }
 
   return false;
 }
 
+unsigned EBOOKCharsetConverter::getGuessSampleSize() const
+{
+  return m_guessSampleSize;
+}
+
+int EBOOKCharsetConverter::getGuessConfidence() const
+{
+  return m_guessConfidence;
+}
+
 bool EBOOKCharsetConverter::convertBytes(const char *const in, const unsigned length, std::vector<char> &out)
 {
   assert(m_converterToUnicode);
   assert(m_converterToUTF8);
   assert(0 != length); // the caller likely needs to check this anyway
 
-  if (out.empty())
-    out.resize(length);
+  if (!needsConversion(in, length))
+  {
+    out.assign(in, in + length);
+    return true;
+  }
+
+  // use all the capacity a reused buffer already has
+  out.resize(std::max(out.capacity(), estimateConvertedLength(length)));
+
+  // The conversion is resumed after the output buffer is grown, so the
+  // pivot must survive between the calls.
+  UChar pivot[PIVOT_SIZE];
+  UChar *pivotSource = pivot;
+  UChar *pivotTarget = pivot;
+
+  const char *inText = in;
+  const char *const inEnd = in + length;
+  vector<char>::size_type outPos = 0;
+  UBool reset = TRUE;
 
   while (true)
   {
-    const char *inText = in;
-    char *outText = &out[0];
+    char *outText = &out[0] + outPos;
     UErrorCode status = U_ZERO_ERROR;
     ucnv_convertEx(
       m_converterToUTF8.get(), m_converterToUnicode.get(),
-      &outText, outText + out.size(), &inText, inText + length,
-      nullptr, nullptr, nullptr, nullptr,
-      TRUE, TRUE, &status)
+      &outText, &out[0] + out.size(), &inText, inEnd,
+      pivot, &pivotSource, &pivotTarget, pivot + PIVOT_SIZE,
+      reset, TRUE, &status)
     ;
-    if (status==U_BUFFER_OVERFLOW_ERROR)
+    reset = FALSE;
+    outPos = static_cast<vector<char>::size_type>(outText - &out[0]);
+
+    if (status == U_BUFFER_OVERFLOW_ERROR)
     {
-      out.resize(out.size() + length);
+      // grow by the expected size of the rest, using the ratio seen so far
+      const auto consumed = static_cast<vector<char>::size_type>(inText - in);
+      const auto rest = static_cast<vector<char>::size_type>(inEnd - inText);
+      const vector<char>::size_type extra = (0 == consumed) ? length : rest * outPos / consumed;
+      out.resize(out.size() + extra + extra / 8 + 16);
       continue;
     }
-    if (status!=U_STRING_NOT_TERMINATED_WARNING && status!=U_ZERO_ERROR)
+    if (status != U_STRING_NOT_TERMINATED_WARNING && status != U_ZERO_ERROR)
       return false;
-    auto outLength = static_cast<int>(outText - &out[0]);
-    out.erase(out.begin() + outLength, out.end());
     break;
   }
 
+  out.resize(outPos);
+  return true;
+}
+
+
+const char *EBOOKCharsetConverter::convertBytes(const char *const in, const unsigned length, std::vector<char> &out, unsigned &outLength)
+{
+  assert(m_converterToUnicode);
+  assert(0 != length);
+
+  if (!needsConversion(in, length))
+  {
+    outLength = length;
+    return in;
+  }
+
+  if (!convertBytes(in, length, out))
+    return nullptr;
+  outLength = static_cast<unsigned>(out.size());
+  return out.empty() ? in : &out[0];
+}
+
+bool EBOOKCharsetConverter::convertPart(const char *&in, const char *const inEnd, char *&out, char *const outEnd, const bool flush)
+{
+  assert(m_converterToUnicode);
+  assert(m_converterToUTF8);
+
+  if (m_pivot.empty())
+  {
+    m_pivot.resize(PIVOT_SIZE);
+    m_pivotSource = m_pivotTarget = &m_pivot[0];
+  }
+
+  UErrorCode status = U_ZERO_ERROR;
+  ucnv_convertEx(
+    m_converterToUTF8.get(), m_converterToUnicode.get(),
+    &out, outEnd, &in, inEnd,
+    &m_pivot[0], &m_pivotSource, &m_pivotTarget, &m_pivot[0] + m_pivot.size(),
+    FALSE, flush ? TRUE : FALSE, &status)
+  ;
+
+  // a full output is not an error here
+  return (status == U_BUFFER_OVERFLOW_ERROR) || (status == U_STRING_NOT_TERMINATED_WARNING) || (status == U_ZERO_ERROR);
+}
+
+void EBOOKCharsetConverter::reset()
+{
+  if (m_converterToUnicode)
+    ucnv_resetToUnicode(m_converterToUnicode.get());
+  ucnv_resetFromUnicode(m_converterToUTF8.get());
+  if (!m_pivot.empty())
+    m_pivotSource = m_pivotTarget = &m_pivot[0];
+}
+
+const char *EBOOKCharsetConverter::getEncoding() const
+{
+  if (!m_converterToUnicode)
+    return nullptr;
+
+  UErrorCode status = U_ZERO_ERROR;
+  const char *const name = ucnv_getName(m_converterToUnicode.get(), &status);
+  return U_SUCCESS(status) ? name : nullptr;
+}
+
+EBOOKCharsetConverter::CacheStatistics EBOOKCharsetConverter::getCacheStatistics()
+{
+  return ConverterPool::get().getStatistics();
+}
+
+void EBOOKCharsetConverter::updatePassThrough()
+{
+  m_passThrough = PASS_THROUGH_NONE;
+
+  switch (ucnv_getType(m_converterToUnicode.get()))
+  {
+  case UCNV_UTF8 :
+    m_passThrough = PASS_THROUGH_UTF8;
+    return;
+  case UCNV_SBCS :
+  case UCNV_MBCS :
+  case UCNV_LATIN_1 :
+  case UCNV_US_ASCII :
+    // stateless encodings, which are usually supersets of ASCII
+    break;
+  default :
+    return;
+  }
+
+  char ascii[0x80];
+  for (unsigned i = 0; i != sizeof(ascii); ++i)
+    ascii[i] = char(i);
+  char converted[sizeof(ascii)];
+
+  const char *inText = ascii;
+  char *outText = converted;
+  UErrorCode status = U_ZERO_ERROR;
+  ucnv_convertEx(
+    m_converterToUTF8.get(), m_converterToUnicode.get(),
+    &outText, outText + sizeof(converted), &inText, inText + sizeof(ascii),
+    nullptr, nullptr, nullptr, nullptr,
+    TRUE, TRUE, &status)
+  ;
+  if (U_SUCCESS(status) && (outText == converted + sizeof(converted)) && std::equal(ascii, ascii + sizeof(ascii), converted))
+    m_passThrough = PASS_THROUGH_ASCII;
+}
+
+std::vector<char>::size_type EBOOKCharsetConverter::estimateConvertedLength(const unsigned length) const
+{
+  // a character of the source encoding is at least minCharSize bytes
+  // long and is rarely more than 3 bytes in UTF-8
+  const auto minCharSize = static_cast<vector<char>::size_type>(std::max<int8_t>(1, ucnv_getMinCharSize(m_converterToUnicode.get())));
+  if (SHORT_INPUT_LENGTH >= length)
+    return (length * 3) / minCharSize + 16;
+  return std::max<vector<char>::size_type>(length, (length * 3) / (2 * minCharSize));
+}
+
+bool EBOOKCharsetConverter::needsConversion(const char *const in, const unsigned length) const
+{
+  switch (m_passThrough)
+  {
+  case PASS_THROUGH_ASCII :
+    return !isASCII(in, length);
+  case PASS_THROUGH_UTF8 :
+    return !isValidUTF8(in, length);
+  default :
+    break;
+  }
   return true;
 }
 
@@ -24,18 +24,124 @@ class EBOOKCharsetConverter
   EBOOKCharsetConverter(const EBOOKCharsetConverter &other);
   EBOOKCharsetConverter &operator=(const EBOOKCharsetConverter &other);
 
+public:
+  /** Statistics of the process-wide cache of ICU converters.
+    */
+  struct CacheStatistics
+  {
+    unsigned long hits; //< the number of converters taken from the cache
+    unsigned long misses; //< the number of converters that had to be opened
+  };
+
 public:
   explicit EBOOKCharsetConverter(const char *encoding = nullptr);
   ~EBOOKCharsetConverter();
 
+  /** Guess the encoding of a text.
+    *
+    * Only a sample of a long text is used: the start of the text and,
+    * if the guess is not confident enough, evenly spaced parts of the
+    * rest.
+    *
+    * @arg[in] in the text
+    * @arg[in] length the length of the text
+    * @return true if the encoding is known
+    */
   bool guessEncoding(const char *in, unsigned length);
 
+  /** Get the size of the sample used by the last guess of encoding.
+    */
+  unsigned getGuessSampleSize() const;
+
+  /** Get the confidence of the last guess of encoding, in range [0, 100].
+    */
+  int getGuessConfidence() const;
+
+  /** Convert a text to UTF-8.
+    *
+    * The content of @c out is replaced, but its capacity is reused, so
+    * it is cheap to pass the same buffer for many short texts.
+    *
+    * @arg[in] in the text
+    * @arg[in] length the length of the text
+    * @arg[out] out the converted text
+    * @return false if the conversion failed
+    */
   bool convertBytes(const char *in, unsigned length, std::vector<char> &out);
 
+  /** Convert a text, avoiding the copy if possible.
+    *
+    * If the text is already valid UTF-8 (or pure ASCII in an encoding
+    * that is a superset of ASCII), it is returned as is. Otherwise it
+    * is converted into @c out.
+    *
+    * @arg[in] in the text
+    * @arg[in] length the length of the text
+    * @arg[out] out the buffer for the converted text
+    * @arg[out] outLength the length of the result
+    * @return the result, either @c in or the data of @c out, or nullptr
+    *   if the conversion failed
+    */
+  const char *convertBytes(const char *in, unsigned length, std::vector<char> &out, unsigned &outLength);
+
+  /** Convert a part of the input.
+    *
+    * Unlike convertBytes(), the state of the conversion is kept between
+    * calls, so the input can be split at any place. The conversion stops
+    * when either the input is used up or the output is full.
+    *
+    * @arg[in,out] in the start of the input. It is moved past the
+    *   converted data.
+    * @arg[in] inEnd the end of the input
+    * @arg[in,out] out the start of the output. It is moved past the
+    *   written data.
+    * @arg[in] outEnd the end of the output
+    * @arg[in] flush true if the input ends at @c inEnd
+    * @return false if the conversion failed
+    */
+  bool convertPart(const char *&in, const char *inEnd, char *&out, char *outEnd, bool flush);
+
+  /** Reset the state of the conversion done by convertPart().
+    */
+  void reset();
+
+  /** Get the name of the source encoding.
+    *
+    * @return the name, or nullptr if the encoding is not known yet
+    */
+  const char *getEncoding() const;
+
+  /** Get statistics of the cache of ICU converters.
+    *
+    * The opened converters are shared by all instances of this class,
+    * so they do not have to be opened again for every text.
+    */
+  static CacheStatistics getCacheStatistics();
+
+private:
+  /** Kinds of input that do not need any conversion.
+    */
+  enum PassThrough
+  {
+    PASS_THROUGH_NONE, //< everything must be converted
+    PASS_THROUGH_ASCII, //< 7-bit ASCII text is passed as is
+    PASS_THROUGH_UTF8 //< valid UTF-8 text is passed as is
+  };
+
+  void updatePassThrough();
+  std::vector<char>::size_type estimateConvertedLength(unsigned length) const;
+  bool needsConversion(const char *in, unsigned length) const;
+
 private:
   using UConverterPtr_t = std::unique_ptr<UConverter, void (*)(UConverter *)>;
   UConverterPtr_t m_converterToUnicode;
   UConverterPtr_t m_converterToUTF8;
+  std::vector<UChar> m_pivot; //< the pivot buffer of convertPart()
+  UChar *m_pivotSource;
+  UChar *m_pivotTarget;
+  unsigned m_guessSampleSize;
+  int m_guessConfidence;
+  PassThrough m_passThrough;
 };
 
 }
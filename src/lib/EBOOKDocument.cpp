@@ -22,6 +22,7 @@
 #include "libebook_utils.h"
 #include "libebook_xml.h"
 #include "EBOOKHTMLToken.h"
+#include "EBOOKMetadataDocument.h"
 #include "EBOOKOPFToken.h"
 #include "EPubToken.h"
 #include "FictionBook2Parser.h"
@@ -76,54 +77,98 @@ static const unsigned char XML_DECL_UTF8[] = "<?xml ";
 static const unsigned char XML_DECL_UTF16BE[] = "\0<\0?\0x\0m\0l\0 ";
 static const unsigned char XML_DECL_UTF16LE[] = "<\0?\0x\0m\0l\0 \0";
 
-BOMEncoding detectBOMEncoding(RVNGInputStream *const input)
+/** Maximal length of an XML declaration start, including BOM.
+  */
+const unsigned long XML_DETECTION_LENGTH = EBOOK_NUM_ELEMENTS(BOM_UTF8) - 1 + EBOOK_NUM_ELEMENTS(XML_DECL_UTF16BE) - 1;
+
+/** Size of the file prefix used for signature-based format detection.
+  */
+const unsigned long DETECTION_HEADER_SIZE = 4096;
+
+template<std::size_t N>
+bool startsWith(const unsigned char *const data, const unsigned long length, const unsigned char (&signature)[N])
+{
+  // the signatures are string literals, so ignore the terminating 0
+  return (N - 1 <= length) && equal(signature, signature + N - 1, data);
+}
+
+BOMEncoding detectBOMEncoding(const unsigned char *const data, const unsigned long length, unsigned &bomLength)
 {
   BOMEncoding encoding = BOM_ENCODING_OTHER;
+  bomLength = 0;
 
-  const unsigned char *const bom = readNBytes(input, 3);
-  if (equal(BOM_UTF8, BOM_UTF8 + EBOOK_NUM_ELEMENTS(BOM_UTF8) - 1, bom))
+  if (startsWith(data, length, BOM_UTF8))
+  {
     encoding = BOM_ENCODING_UTF8;
-  else if (equal(BOM_UTF16BE, BOM_UTF16BE + EBOOK_NUM_ELEMENTS(BOM_UTF16BE) - 1, bom))
+    bomLength = EBOOK_NUM_ELEMENTS(BOM_UTF8) - 1;
+  }
+  else if (startsWith(data, length, BOM_UTF16BE))
+  {
     encoding = BOM_ENCODING_UTF16BE;
-  else if (equal(BOM_UTF16LE, BOM_UTF16LE + EBOOK_NUM_ELEMENTS(BOM_UTF16LE) - 1, bom))
+    bomLength = EBOOK_NUM_ELEMENTS(BOM_UTF16BE) - 1;
+  }
+  else if (startsWith(data, length, BOM_UTF16LE))
+  {
     encoding = BOM_ENCODING_UTF16LE;
-  else
-    seek(input, 0); // no BOM, return the swallowed chars back
+    bomLength = EBOOK_NUM_ELEMENTS(BOM_UTF16LE) - 1;
+  }
 
   return encoding;
 }
 
-bool isXML(RVNGInputStream *const input)
+bool isXML(const unsigned char *const data, const unsigned long length)
 {
-  bool xml = false;
+  unsigned bomLength = 0;
+  const BOMEncoding bom = detectBOMEncoding(data, length, bomLength);
 
-  const unsigned char *decl = nullptr;
-  unsigned len = 0;
+  const unsigned char *const start = data + bomLength;
+  const unsigned long len = length - bomLength;
 
-  const BOMEncoding bom = detectBOMEncoding(input);
   switch (bom)
   {
   case BOM_ENCODING_UTF16BE :
-    decl = XML_DECL_UTF16BE;
-    len = EBOOK_NUM_ELEMENTS(XML_DECL_UTF16BE) - 1;
-    break;
+    return startsWith(start, len, XML_DECL_UTF16BE);
   case BOM_ENCODING_UTF16LE :
-    decl = XML_DECL_UTF16LE;
-    len = EBOOK_NUM_ELEMENTS(XML_DECL_UTF16LE) - 1;
-    break;
+    return startsWith(start, len, XML_DECL_UTF16LE);
   case BOM_ENCODING_UTF8 :
   case BOM_ENCODING_OTHER:
   default :
-    len = EBOOK_NUM_ELEMENTS(XML_DECL_UTF8) - 1;
-    decl = XML_DECL_UTF8;
+    return startsWith(start, len, XML_DECL_UTF8);
   }
+}
+
+/** Read up to @c size bytes from the start of the stream.
+  *
+  * @arg[in] input the input stream
+  * @arg[out] buffer the buffer to fill
+  * @arg[in] size the size of the buffer
+  * @return the number of bytes actually read
+  */
+unsigned long readDetectionHeader(RVNGInputStream *const input, unsigned char *const buffer, const unsigned long size)
+{
+  seek(input, 0);
 
-  const unsigned char *const data = readNBytes(input, len);
-  xml = equal(decl, decl + len, data);
+  unsigned long length = 0;
+  while ((length < size) && !input->isEnd())
+  {
+    unsigned long readBytes = 0;
+    const unsigned char *const data = input->read(size - length, readBytes);
+    if (!data || (0 == readBytes))
+      break;
+    std::copy(data, data + readBytes, buffer + length);
+    length += readBytes;
+  }
 
   seek(input, 0);
 
-  return xml;
+  return length;
+}
+
+bool isXML(RVNGInputStream *const input)
+{
+  unsigned char header[XML_DETECTION_LENGTH];
+  const unsigned long length = readDetectionHeader(input, header, sizeof(header));
+  return isXML(header, length);
 }
 
 EBOOKDocument::Type detectXML(RVNGInputStream *const input) try
@@ -270,6 +315,12 @@ bool findFB2Stream(const RVNGInputStreamPtr_t &package, unsigned &id)
 template<class Parser>
 bool probe(const RVNGInputStreamPtr_t &input, const EBOOKDocument::Type type, EBOOKDocument::Type *const typeOut, EBOOKDocument::Confidence &confidence) try
 {
+  confidence = EBOOKDocument::CONFIDENCE_NONE;
+
+  // check cheaply first, so the parser only throws for broken files
+  if (!Parser::isSupported(input.get()))
+    return false;
+
   seek(input, 0);
 
   Parser parser(input);
@@ -294,6 +345,11 @@ catch (...)
 template<class Parser>
 bool probePtr(RVNGInputStream *input, const EBOOKDocument::Type type, EBOOKDocument::Type *const typeOut, EBOOKDocument::Confidence &confidence) try
 {
+  confidence = EBOOKDocument::CONFIDENCE_NONE;
+
+  if (!Parser::isSupported(input))
+    return false;
+
   seek(input, 0);
 
   Parser parser(input);
@@ -316,50 +372,204 @@ catch (...)
 }
 
 typedef bool (*CheckTypeFun_t)(unsigned, unsigned);
-typedef bool (*ProbeFun_t)(RVNGInputStream *, EBOOKDocument::Type, EBOOKDocument::Type *, EBOOKDocument::Confidence &);
+typedef PDBParser *(*CreateFun_t)(RVNGInputStream *);
+
+template<class Parser>
+PDBParser *createPalmParser(RVNGInputStream *const input)
+{
+  return new Parser(input);
+}
 
 struct PalmDetector
 {
   CheckTypeFun_t checkFun;
-  ProbeFun_t probeFun;
+  CreateFun_t createFun;
   EBOOKDocument::Type type;
 };
 
 static PalmDetector PALM_DETECTORS[] =
 {
-  {PalmDocParser::checkType, probePtr<PalmDocParser>, EBOOKDocument::TYPE_PALMDOC},
-  {PluckerParser::checkType, probePtr<PluckerParser>, EBOOKDocument::TYPE_PLUCKER},
-  {PeanutPressParser::checkType, probePtr<PeanutPressParser>, EBOOKDocument::TYPE_PEANUTPRESS},
-  {TealDocParser::checkType, probePtr<TealDocParser>, EBOOKDocument::TYPE_TEALDOC},
-  {ZTXTParser::checkType, probePtr<ZTXTParser>, EBOOKDocument::TYPE_ZTXT}
+  {PalmDocParser::checkType, createPalmParser<PalmDocParser>, EBOOKDocument::TYPE_PALMDOC},
+  {PluckerParser::checkType, createPalmParser<PluckerParser>, EBOOKDocument::TYPE_PLUCKER},
+  {PeanutPressParser::checkType, createPalmParser<PeanutPressParser>, EBOOKDocument::TYPE_PEANUTPRESS},
+  {TealDocParser::checkType, createPalmParser<TealDocParser>, EBOOKDocument::TYPE_TEALDOC},
+  {ZTXTParser::checkType, createPalmParser<ZTXTParser>, EBOOKDocument::TYPE_ZTXT}
 };
 
-bool detectPalm(RVNGInputStream *const input, EBOOKDocument::Type *const type, EBOOKDocument::Confidence &confidence)
+/// Create a parser for a Palm format of the given type.
+PDBParser *createPalmParser(const EBOOKDocument::Type type, RVNGInputStream *const input)
 {
-  unsigned typ = 0;
-  unsigned creator = 0;
-
-  try
+  for (const auto &detector : PALM_DETECTORS)
   {
-    seek(input, 60);
-    typ = readU32(input, true);
-    creator = readU32(input, true);
+    if (type == detector.type)
+      return detector.createFun(input);
   }
-  catch (...)
-  {
+  return nullptr;
+}
+
+bool probePalm(RVNGInputStream *const input, const PalmDetector &detector, EBOOKDocument::Type *const typeOut, unique_ptr<PDBParser> &parser, EBOOKDocument::Confidence &confidence) try
+{
+  confidence = EBOOKDocument::CONFIDENCE_NONE;
+
+  if (!PDBParser::isSupported(input))
     return false;
-  }
+
+  seek(input, 0);
+
+  parser.reset(detector.createFun(input));
+
+  if (typeOut)
+    *typeOut = detector.type;
+  confidence = EBOOKDocument::CONFIDENCE_EXCELLENT;
+
+  return true;
+}
+catch (const UnsupportedEncryption &)
+{
+  confidence = EBOOKDocument::CONFIDENCE_UNSUPPORTED_ENCRYPTION;
+  return false;
+}
+catch (...)
+{
+  confidence = EBOOKDocument::CONFIDENCE_NONE;
+  return false;
+}
+
+unsigned getU16(const unsigned char *const data, const bool bigEndian)
+{
+  if (bigEndian)
+    return unsigned(data[0] << 8) | data[1];
+  return unsigned(data[1] << 8) | data[0];
+}
+
+unsigned getU32(const unsigned char *const data, const bool bigEndian)
+{
+  if (bigEndian)
+    return (unsigned(data[0]) << 24) | (unsigned(data[1]) << 16) | (unsigned(data[2]) << 8) | data[3];
+  return (unsigned(data[3]) << 24) | (unsigned(data[2]) << 16) | (unsigned(data[1]) << 8) | data[0];
+}
+
+/** Find the detector for a Palm database with the given header.
+  *
+  * @return the detector, or nullptr if the type and creator are not
+  *         recognized
+  */
+const PalmDetector *findPalmDetector(const unsigned char *const data, const unsigned long length)
+{
+  if (length < 68)
+    return nullptr;
+
+  const unsigned typ = getU32(data + 60, true);
+  const unsigned creator = getU32(data + 64, true);
 
   for (int i = 0; EBOOK_NUM_ELEMENTS(PALM_DETECTORS) != i; ++i)
   {
     const PalmDetector &detector = PALM_DETECTORS[i];
     if ((detector.checkFun)(typ, creator))
-      return detector.probeFun(input, detector.type, type, confidence);
+      return &detector;
   }
 
-  return false;
+  return nullptr;
+}
+
+bool checkPalmSignature(const unsigned char *const data, const unsigned long length)
+{
+  return bool(findPalmDetector(data, length));
+}
+
+bool checkSoftBookSignature(const unsigned char *const data, const unsigned long length)
+{
+  static const unsigned char signature[] = "BOOKDOUG";
+
+  if (length < 2)
+    return false;
+  const unsigned version = getU16(data, true);
+  return ((1 == version) || (2 == version)) && startsWith(data + 2, length - 2, signature);
+}
+
+bool checkBBeBSignature(const unsigned char *const data, const unsigned long length)
+{
+  static const unsigned char signature[] = "L\0R\0F\0";
+  return startsWith(data, length, signature);
+}
+
+bool checkTCRSignature(const unsigned char *const data, const unsigned long length)
+{
+  static const unsigned char signature[] = "!!8-Bit!!";
+  return startsWith(data, length, signature);
+}
+
+bool checkZVRSignature(const unsigned char *const data, const unsigned long length)
+{
+  static const unsigned char signature[] = "!!Compressed!!\n";
+  return startsWith(data, length, signature);
+}
+
+#if defined LIBE_BOOK_EXPERIMENTAL
+
+bool checkHTMLSignature(const unsigned char *const data, const unsigned long length)
+{
+  return bool(std::memchr(data, '<', length));
+}
+
+bool checkRocketEBookSignature(const unsigned char *const data, const unsigned long length)
+{
+  return (6 <= length) && (0x0cb00cb0 == getU32(data, false)) && (2 == getU16(data + 4, false));
 }
 
+bool checkHTMLHelpSignature(const unsigned char *const data, const unsigned long length)
+{
+  static const unsigned char signature[] = "ITSF";
+  return startsWith(data, length, signature);
+}
+
+#endif
+
+typedef bool (*CheckSignatureFun_t)(const unsigned char *, unsigned long);
+
+/** Format candidates that can be recognized by a signature.
+  */
+enum Candidate
+{
+  CANDIDATE_PALM,
+  CANDIDATE_XML,
+  CANDIDATE_SOFTBOOK,
+  CANDIDATE_BBEB,
+  CANDIDATE_ROCKETEBOOK,
+  CANDIDATE_HTMLHELP,
+  CANDIDATE_TCR,
+  CANDIDATE_ZVR,
+  CANDIDATE_HTML
+};
+
+struct SignatureDetector
+{
+  CheckSignatureFun_t checkFun;
+  Candidate candidate;
+};
+
+/** Signature checks, ordered from the most specific to the least.
+  *
+  * The checks only look at a prefix of the file, so they are cheap.
+  * A matching candidate must still be confirmed by a parser.
+  */
+static const SignatureDetector SIGNATURE_DETECTORS[] =
+{
+  {checkPalmSignature, CANDIDATE_PALM},
+  {isXML, CANDIDATE_XML},
+  {checkSoftBookSignature, CANDIDATE_SOFTBOOK},
+  {checkBBeBSignature, CANDIDATE_BBEB},
+#if defined LIBE_BOOK_EXPERIMENTAL
+  {checkRocketEBookSignature, CANDIDATE_ROCKETEBOOK},
+  {checkHTMLHelpSignature, CANDIDATE_HTMLHELP},
+#endif
+  {checkTCRSignature, CANDIDATE_TCR},
+  {checkZVRSignature, CANDIDATE_ZVR},
+#if defined LIBE_BOOK_EXPERIMENTAL
+  {checkHTMLSignature, CANDIDATE_HTML},
+#endif
+};
+
 template<class Parser>
 EBOOKDocument::Result doParse(RVNGInputStream *const input, librevenge::RVNGTextInterface *const document)
 {
@@ -376,15 +586,131 @@ EBOOKDocument::Result doParse(const RVNGInputStreamPtr_t &input, librevenge::RVN
   return EBOOKDocument::RESULT_OK;
 }
 
+/** Map the exception currently being handled to a parse result.
+  *
+  * This must only be called from a catch block.
+  */
+EBOOKDocument::Result getResultForException()
+{
+  try
+  {
+    throw;
+  }
+  catch (const FileAccessError &)
+  {
+    return EBOOKDocument::RESULT_FILE_ACCESS_ERROR;
+  }
+  catch (const PackageError &)
+  {
+    return EBOOKDocument::RESULT_PACKAGE_ERROR;
+  }
+  catch (const PasswordMismatch &)
+  {
+    return EBOOKDocument::RESULT_PASSWORD_MISMATCH;
+  }
+  catch (const UnsupportedEncryption &)
+  {
+    return EBOOKDocument::RESULT_UNSUPPORTED_ENCRYPTION;
+  }
+  catch (const UnsupportedFormat &)
+  {
+    return EBOOKDocument::RESULT_UNSUPPORTED_FORMAT;
+  }
+  catch (...)
+  {
+    return EBOOKDocument::RESULT_UNKNOWN_ERROR;
+  }
 }
 
-EBOOKAPI EBOOKDocument::Confidence EBOOKDocument::isSupported(librevenge::RVNGInputStream *const input, Type *const type) try
+/** Check if a document detected with the given confidence can be parsed.
+  *
+  * @return RESULT_OK if it can, the reason why not otherwise
+  */
+EBOOKDocument::Result getResultForConfidence(const EBOOKDocument::Confidence confidence)
 {
+  switch (confidence)
+  {
+  case EBOOKDocument::CONFIDENCE_NONE :
+  case EBOOKDocument::CONFIDENCE_SUPPORTED_PART :
+    return EBOOKDocument::RESULT_UNSUPPORTED_FORMAT;
+  case EBOOKDocument::CONFIDENCE_UNSUPPORTED_ENCRYPTION :
+    return EBOOKDocument::RESULT_UNSUPPORTED_ENCRYPTION;
+  case EBOOKDocument::CONFIDENCE_WEAK :
+  case EBOOKDocument::CONFIDENCE_SUPPORTED_ENCRYPTION :
+  case EBOOKDocument::CONFIDENCE_EXCELLENT :
+  default :
+    break;
+  }
+
+  return EBOOKDocument::RESULT_OK;
+}
+
+}
+
+class EBOOKDocument::Handle
+{
+  // disable copying
+  Handle(const Handle &other);
+  Handle &operator=(const Handle &other);
+
+public:
+  explicit Handle(RVNGInputStream *input);
+
+  /** Detect the format of the input.
+    *
+    * Data read during the detection that are useful for parsing too
+    * are kept.
+    */
+  Confidence detect();
+
+  /** Confirm that the input is in the candidate format.
+    *
+    * @return true if the format has been confirmed
+    */
+  bool confirm(Candidate candidate, const unsigned char *header, unsigned long headerLength, Confidence &confidence);
+
+  Result parse(librevenge::RVNGTextInterface *document);
+
+  /** Parse only the metadata of the input.
+    *
+    * Formats without a dedicated way to read the metadata are parsed
+    * completely, but only the metadata are passed to @c document.
+    */
+  Result parseMetadata(librevenge::RVNGTextInterface *document);
+
+  RVNGInputStream *const m_input;
+  Type m_type;
+  Confidence m_confidence;
+  unsigned m_threadCount; //< the max. number of threads used to parse
+
+  unique_ptr<PDBParser> m_palmParser; //< Parser created for a Palm format.
+  shared_ptr<SoftBookHeader> m_softBookHeader;
+  shared_ptr<BBeBHeader> m_bbebHeader;
+  unsigned m_fb2Stream; //< FictionBook2 stream in a package.
+  bool m_fb2StreamFound;
+};
+
+EBOOKDocument::Handle::Handle(RVNGInputStream *const input)
+  : m_input(input)
+  , m_type(TYPE_UNKNOWN)
+  , m_confidence(CONFIDENCE_NONE)
+  , m_threadCount(1)
+  , m_palmParser()
+  , m_softBookHeader()
+  , m_bbebHeader()
+  , m_fb2Stream(0)
+  , m_fb2StreamFound(false)
+{
+}
+
+EBOOKDocument::Confidence EBOOKDocument::Handle::detect() try
+{
+  RVNGInputStream *const input = m_input;
+
   if (!input)
     return CONFIDENCE_NONE;
 
-  if (type)
-    *type = TYPE_UNKNOWN;
+  m_type = TYPE_UNKNOWN;
 
   if (input->isStructured())
   {
@@ -395,8 +721,7 @@ EBOOKAPI EBOOKDocument::Confidence EBOOKDocument::isSupported(librevenge::RVNGIn
       const unsigned char *const data = readNBytes(mimetype.get(), sizeof(mime));
       if (EPubToken::MIME_epub == getEPubTokenId(char_cast(data), sizeof(mime)))
       {
-        if (type)
-          *type = TYPE_EPUB;
+        m_type = TYPE_EPUB;
         return CONFIDENCE_EXCELLENT;
       }
     }
@@ -407,16 +732,14 @@ EBOOKAPI EBOOKDocument::Confidence EBOOKDocument::isSupported(librevenge::RVNGIn
       const Type xmlType = detectXML(container.get());
       if (TYPE_EPUB == xmlType)
       {
-        if (type)
-          *type = TYPE_EPUB;
+        m_type = TYPE_EPUB;
         return CONFIDENCE_EXCELLENT;
       }
     }
 
     if ((input->existsSubStream("reader/MobileLibrary.class")) && (input->existsSubStream("data")))
     {
-      if (type)
-        *type = TYPE_QIOO;
+      m_type = TYPE_QIOO;
       return CONFIDENCE_WEAK;
     }
 
@@ -431,8 +754,7 @@ EBOOKAPI EBOOKDocument::Confidence EBOOKDocument::isSupported(librevenge::RVNGIn
         const Type xmlType = detectXML(opf.get());
         if ((TYPE_EPUB == xmlType) || (TYPE_OPENEBOOK == xmlType))
         {
-          if (type)
-            *type = xmlType;
+          m_type = xmlType;
           return CONFIDENCE_EXCELLENT;
         }
       }
@@ -446,98 +768,236 @@ EBOOKAPI EBOOKDocument::Confidence EBOOKDocument::isSupported(librevenge::RVNGIn
       const Type xmlType = detectXML(fb2.get());
       if (TYPE_FICTIONBOOK2 == xmlType)
       {
-        if (type)
-          *type = xmlType;
+        m_type = xmlType;
+        m_fb2Stream = fb2Stream;
+        m_fb2StreamFound = true;
         return CONFIDENCE_EXCELLENT;
       }
     }
   }
 
-  Confidence confidence = CONFIDENCE_NONE;
+  unsigned char header[DETECTION_HEADER_SIZE];
+  const unsigned long headerLength = readDetectionHeader(input, header, sizeof(header));
 
-  if (detectPalm(input, type, confidence))
-    return confidence;
-
-  Type xmlType = detectXML(input);
-  if (TYPE_UNKNOWN != xmlType)
+  for (int i = 0; EBOOK_NUM_ELEMENTS(SIGNATURE_DETECTORS) != i; ++i)
   {
-    if (type)
-      *type = xmlType;
+    const SignatureDetector &detector = SIGNATURE_DETECTORS[i];
+    Confidence confidence = CONFIDENCE_NONE;
+    if ((detector.checkFun)(header, headerLength) && confirm(detector.candidate, header, headerLength, confidence))
+      return confidence;
+  }
+
+  return CONFIDENCE_NONE;
+}
+catch (...)
+{
+  return CONFIDENCE_NONE;
+}
 
+bool EBOOKDocument::Handle::confirm(const Candidate candidate, const unsigned char *const header, const unsigned long headerLength, Confidence &confidence)
+{
+  RVNGInputStream *const input = m_input;
+  Type *const type = &m_type;
+
+  switch (candidate)
+  {
+  case CANDIDATE_PALM :
+  {
+    const PalmDetector *const detector = findPalmDetector(header, headerLength);
+    return detector && probePalm(input, *detector, type, m_palmParser, confidence);
+  }
+  case CANDIDATE_XML :
+  {
+    const Type xmlType = detectXML(input);
+    if (TYPE_UNKNOWN == xmlType)
+      return false;
+    m_type = xmlType;
     if ((TYPE_EPUB == xmlType) || (TYPE_OPENEBOOK == xmlType))
-      return CONFIDENCE_SUPPORTED_PART;
+      confidence = CONFIDENCE_SUPPORTED_PART;
     else
-      return CONFIDENCE_EXCELLENT;
+      confidence = CONFIDENCE_EXCELLENT;
+    return true;
   }
-
+  case CANDIDATE_SOFTBOOK :
+    seek(input, 0);
+    m_softBookHeader = SoftBookHeader::create(input);
+    if (!m_softBookHeader)
+      return false;
+    m_type = TYPE_SOFTBOOK;
+    confidence = CONFIDENCE_EXCELLENT;
+    return true;
+  case CANDIDATE_BBEB :
+    m_bbebHeader = BBeBParser::createHeader(input);
+    if (!m_bbebHeader)
+      return false;
+    m_type = TYPE_BBEB;
+    confidence = CONFIDENCE_EXCELLENT;
+    return true;
 #if defined LIBE_BOOK_EXPERIMENTAL
-  if (detectHTML(input))
-  {
-    if (type)
-      *type = TYPE_HTML;
-    return CONFIDENCE_EXCELLENT;
-  }
+  case CANDIDATE_ROCKETEBOOK :
+    return probe<RocketEBookParser>(RVNGInputStreamPtr_t(input, EBOOKDummyDeleter()), TYPE_ROCKETEBOOK, type, confidence);
+  case CANDIDATE_HTMLHELP :
+    return probe<HTMLHelpStream>(RVNGInputStreamPtr_t(input, EBOOKDummyDeleter()), TYPE_HTMLHELP, type, confidence);
+  case CANDIDATE_HTML :
+    if (!detectHTML(input))
+      return false;
+    m_type = TYPE_HTML;
+    confidence = CONFIDENCE_EXCELLENT;
+    return true;
 #endif
+  case CANDIDATE_TCR :
+    if (!probePtr<TCRParser>(input, TYPE_TCR, type, confidence))
+      return false;
+    confidence = CONFIDENCE_WEAK;
+    return true;
+  case CANDIDATE_ZVR :
+    if (!probePtr<ZVRParser>(input, TYPE_ZVR, type, confidence))
+      return false;
+    confidence = CONFIDENCE_WEAK;
+    return true;
+  default :
+    break;
+  }
 
-  seek(input, 0);
+  return false;
+}
 
+EBOOKDocument::Result EBOOKDocument::Handle::parse(librevenge::RVNGTextInterface *const document)
+{
+  seek(m_input, 0);
+
+  switch (m_type)
   {
-    const std::shared_ptr<SoftBookHeader> header(SoftBookHeader::create(input));
-    if (bool(header))
+  case TYPE_FICTIONBOOK2 :
+    if (m_fb2StreamFound)
+    {
+      const unique_ptr<RVNGInputStream> fb2Input(m_input->getSubStreamById(m_fb2Stream));
+      if (!fb2Input)
+        return RESULT_PACKAGE_ERROR;
+      FictionBook2Parser parser(fb2Input.get());
+      return parser.parse(document) ? RESULT_OK : RESULT_UNKNOWN_ERROR;
+    }
+    break;
+  case TYPE_SOFTBOOK :
+    if (bool(m_softBookHeader))
+    {
+      SoftBookParser parser(m_input, document, *m_softBookHeader);
+      parser.parse();
+      return RESULT_OK;
+    }
+    break;
+  case TYPE_BBEB :
+    if (bool(m_bbebHeader))
     {
-      if (type)
-        *type = TYPE_SOFTBOOK;
-      return CONFIDENCE_EXCELLENT;
+      BBeBParser parser(m_input, document, m_bbebHeader);
+      parser.setThreadCount(m_threadCount);
+      parser.parse();
+      return RESULT_OK;
     }
+    break;
+  case TYPE_PALMDOC :
+  case TYPE_PLUCKER :
+  case TYPE_PEANUTPRESS :
+  case TYPE_TEALDOC :
+  case TYPE_ZTXT :
+  {
+    // the parser keeps state of the parsing run, so it can only be used once
+    unique_ptr<PDBParser> parser(std::move(m_palmParser));
+    if (!parser)
+      parser.reset(createPalmParser(m_type, m_input));
+    parser->setDocument(document);
+    parser->setThreadCount(m_threadCount);
+    parser->parse();
+    return RESULT_OK;
+  }
+  default :
+    break;
   }
 
-  seek(input, 0);
+  return EBOOKDocument::parse(m_input, document, m_type);
+}
 
-  if (BBeBParser::isSupported(input))
-  {
-    if (type)
-      *type = TYPE_BBEB;
-    return CONFIDENCE_EXCELLENT;
-  }
+EBOOKDocument::Result EBOOKDocument::Handle::parseMetadata(librevenge::RVNGTextInterface *const document)
+{
+  EBOOKMetadataDocument metadataDocument(*document);
 
-  const RVNGInputStreamPtr_t input2(input, EBOOKDummyDeleter());
+  seek(m_input, 0);
 
+  switch (m_type)
+  {
 #if defined LIBE_BOOK_EXPERIMENTAL
-  if (probe<RocketEBookParser>(input2, TYPE_ROCKETEBOOK, type, confidence))
-    return confidence;
-
-  if (probe<HTMLHelpStream>(input2, TYPE_HTMLHELP, type, confidence))
-    return confidence;
+  case TYPE_EPUB :
+  {
+    EPubParser parser(m_input, &metadataDocument);
+    parser.parseMetadata();
+    return RESULT_OK;
+  }
 #endif
+  case TYPE_FICTIONBOOK2 :
+  {
+    unique_ptr<RVNGInputStream> fb2Stream;
+    RVNGInputStream *fb2Input = m_input;
+    if (m_input->isStructured())
+    {
+      unsigned id = m_fb2Stream;
+      if (!m_fb2StreamFound && !findFB2Stream(RVNGInputStreamPtr_t(m_input, EBOOKDummyDeleter()), id))
+        return RESULT_PACKAGE_ERROR;
+      fb2Stream.reset(m_input->getSubStreamById(id));
+      if (!fb2Stream)
+        return RESULT_PACKAGE_ERROR;
+      fb2Input = fb2Stream.get();
+    }
+    FictionBook2Parser parser(fb2Input);
+    return parser.parseMetadata(&metadataDocument) ? RESULT_OK : RESULT_UNKNOWN_ERROR;
+  }
+  case TYPE_BBEB :
+  {
+    BBeBParser parser(m_input, &metadataDocument, m_bbebHeader);
+    parser.parseMetadata();
+    return RESULT_OK;
+  }
+  case TYPE_PALMDOC :
+  case TYPE_ZTXT :
+  {
+    // Reading the metadata does not start a parsing run, so the parser
+    // is kept for parse(), together with the records it has unpacked.
+    if (!m_palmParser)
+      m_palmParser.reset(createPalmParser(m_type, m_input));
+    m_palmParser->setDocument(&metadataDocument);
+    m_palmParser->parseMetadata();
+    m_palmParser->setDocument(nullptr);
+    return RESULT_OK;
+  }
+  default :
+    break;
+  }
 
-  if (probePtr<TCRParser>(input, TYPE_TCR, type, confidence))
-    return CONFIDENCE_WEAK;
-
-  if (probePtr<ZVRParser>(input, TYPE_ZVR, type, confidence))
-    return CONFIDENCE_WEAK;
-
-  return CONFIDENCE_NONE;
+  return parse(&metadataDocument);
 }
-catch (...)
+
+EBOOKAPI EBOOKDocument::Confidence EBOOKDocument::isSupported(librevenge::RVNGInputStream *const input, Type *const type)
 {
-  return CONFIDENCE_NONE;
+  if (type)
+    *type = TYPE_UNKNOWN;
+
+  Handle handle(input);
+  const Confidence confidence = handle.detect();
+
+  if (type)
+    *type = handle.m_type;
+
+  return confidence;
 }
 
-EBOOKAPI EBOOKDocument::Result EBOOKDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document, const char *const)
+EBOOKAPI EBOOKDocument::Result EBOOKDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document, const char *const password)
 {
   if (!input || !document)
     return RESULT_UNSUPPORTED_FORMAT;
 
-  Type type;
-  Confidence confidence = isSupported(input, &type);
-  if (CONFIDENCE_NONE == confidence)
-    return RESULT_UNSUPPORTED_FORMAT;
-  else if (CONFIDENCE_SUPPORTED_PART == confidence)
-    return RESULT_UNSUPPORTED_FORMAT;
-  else if (CONFIDENCE_UNSUPPORTED_ENCRYPTION == confidence)
-    return RESULT_UNSUPPORTED_ENCRYPTION;
+  Handle handle(input);
+  handle.m_confidence = handle.detect();
 
-  return parse(input, document, type);
+  return parse(&handle, document, password);
 }
 
 EBOOKAPI EBOOKDocument::Result EBOOKDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document, const EBOOKDocument::Type type, const char *const) try
@@ -648,29 +1108,91 @@ EBOOKAPI EBOOKDocument::Result EBOOKDocument::parse(librevenge::RVNGInputStream
 
   return RESULT_UNKNOWN_ERROR;
 }
-catch (const FileAccessError &)
+catch (...)
 {
-  return RESULT_FILE_ACCESS_ERROR;
+  return getResultForException();
 }
-catch (const PackageError &)
+
+EBOOKAPI EBOOKDocument::Handle *EBOOKDocument::open(librevenge::RVNGInputStream *const input, Confidence *const confidence, Type *const type) try
 {
-  return RESULT_PACKAGE_ERROR;
+  if (confidence)
+    *confidence = CONFIDENCE_NONE;
+  if (type)
+    *type = TYPE_UNKNOWN;
+
+  if (!input)
+    return nullptr;
+
+  unique_ptr<Handle> handle(new Handle(input));
+  handle->m_confidence = handle->detect();
+
+  if (confidence)
+    *confidence = handle->m_confidence;
+  if (type)
+    *type = handle->m_type;
+
+  if (CONFIDENCE_NONE == handle->m_confidence)
+    return nullptr;
+
+  return handle.release();
+}
+catch (...)
+{
+  return nullptr;
 }
-catch (const PasswordMismatch &)
+
+EBOOKAPI EBOOKDocument::Result EBOOKDocument::parse(Handle *const handle, librevenge::RVNGTextInterface *const document, const char *const) try
 {
-  return RESULT_PASSWORD_MISMATCH;
+  if (!handle || !document)
+    return RESULT_UNSUPPORTED_FORMAT;
+
+  const Result result = getResultForConfidence(handle->m_confidence);
+  if (RESULT_OK != result)
+    return result;
+
+  return handle->parse(document);
 }
-catch (const UnsupportedEncryption &)
+catch (...)
 {
-  return RESULT_UNSUPPORTED_ENCRYPTION;
+  return getResultForException();
 }
-catch (const UnsupportedFormat &)
+
+EBOOKAPI void EBOOKDocument::close(Handle *const handle)
 {
-  return RESULT_UNSUPPORTED_FORMAT;
+  delete handle;
+}
+
+EBOOKAPI EBOOKDocument::Result EBOOKDocument::parseMetadata(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document, const char *const password)
+{
+  if (!input || !document)
+    return RESULT_UNSUPPORTED_FORMAT;
+
+  Handle handle(input);
+  handle.m_confidence = handle.detect();
+
+  return parseMetadata(&handle, document, password);
+}
+
+EBOOKAPI EBOOKDocument::Result EBOOKDocument::parseMetadata(Handle *const handle, librevenge::RVNGTextInterface *const document, const char *const) try
+{
+  if (!handle || !document)
+    return RESULT_UNSUPPORTED_FORMAT;
+
+  const Result result = getResultForConfidence(handle->m_confidence);
+  if (RESULT_OK != result)
+    return result;
+
+  return handle->parseMetadata(document);
 }
 catch (...)
 {
-  return RESULT_UNKNOWN_ERROR;
+  return getResultForException();
+}
+
+EBOOKAPI void EBOOKDocument::setThreadCount(Handle *const handle, const unsigned count)
+{
+  if (handle)
+    handle->m_threadCount = (0 == count) ? 1 : count;
 }
 
 } // namespace libebook
@@ -0,0 +1,275 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <libe-book/EBOOKMappedFileStream.h>
+
+namespace libebook
+{
+
+struct EBOOKMappedFileStream::Impl
+{
+  explicit Impl(const char *filename);
+  ~Impl();
+
+  bool map(const char *filename);
+  bool load(const char *filename);
+
+  const unsigned char *m_data;
+  long m_length;
+  long m_pos;
+  bool m_open;
+  bool m_mapped;
+  std::vector<unsigned char> m_buffer; //< the content of the file, if it could not be mapped
+
+private:
+  Impl(const Impl &other);
+  Impl &operator=(const Impl &other);
+};
+
+EBOOKMappedFileStream::Impl::Impl(const char *const filename)
+  : m_data(nullptr)
+  , m_length(0)
+  , m_pos(0)
+  , m_open(false)
+  , m_mapped(false)
+  , m_buffer()
+{
+  if (!filename)
+    return;
+
+  if (map(filename))
+  {
+    m_mapped = bool(m_data);
+    m_open = true;
+  }
+  else
+  {
+    m_open = load(filename);
+  }
+}
+
+EBOOKMappedFileStream::Impl::~Impl()
+{
+  if (m_mapped)
+  {
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+#else
+    munmap(const_cast<unsigned char *>(m_data), static_cast<size_t>(m_length));
+#endif
+  }
+}
+
+bool EBOOKMappedFileStream::Impl::map(const char *const filename)
+{
+#ifdef _WIN32
+  const HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (INVALID_HANDLE_VALUE == file)
+    return false;
+
+  bool mapped = false;
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(file, &size) && (LONG_MAX >= size.QuadPart))
+  {
+    if (0 == size.QuadPart)
+    {
+      // an empty file cannot be mapped
+      mapped = true;
+    }
+    else
+    {
+      const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping)
+      {
+        const void *const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view)
+        {
+          m_data = static_cast<const unsigned char *>(view);
+          m_length = static_cast<long>(size.QuadPart);
+          mapped = true;
+        }
+        // the view keeps the mapping alive
+        CloseHandle(mapping);
+      }
+    }
+  }
+  CloseHandle(file);
+  return mapped;
+#else
+  const int fd = open(filename, O_RDONLY);
+  if (0 > fd)
+    return false;
+
+  bool mapped = false;
+  struct stat info;
+  if ((0 == fstat(fd, &info)) && S_ISREG(info.st_mode) && (LONG_MAX >= info.st_size))
+  {
+    if (0 == info.st_size)
+    {
+      // an empty file cannot be mapped
+      mapped = true;
+    }
+    else
+    {
+      void *const addr = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (MAP_FAILED != addr)
+      {
+        m_data = static_cast<const unsigned char *>(addr);
+        m_length = static_cast<long>(info.st_size);
+        mapped = true;
+      }
+    }
+  }
+  // the mapping stays valid after the file is closed
+  close(fd);
+  return mapped;
+#endif
+}
+
+bool EBOOKMappedFileStream::Impl::load(const char *const filename)
+{
+  FILE *const file = std::fopen(filename, "rb");
+  if (!file)
+    return false;
+
+  unsigned char buffer[4096];
+  size_t readBytes = 0;
+  while (0 < (readBytes = std::fread(buffer, 1, sizeof(buffer), file)))
+    m_buffer.insert(m_buffer.end(), buffer, buffer + readBytes);
+  const bool ok = !std::ferror(file);
+  std::fclose(file);
+
+  if (!ok || (static_cast<unsigned long>(LONG_MAX) < m_buffer.size()))
+  {
+    m_buffer.clear();
+    return false;
+  }
+
+  if (!m_buffer.empty())
+  {
+    m_data = &m_buffer[0];
+    m_length = static_cast<long>(m_buffer.size());
+  }
+  return true;
+}
+
+EBOOKMappedFileStream::EBOOKMappedFileStream(const char *const filename)
+  : m_impl(new Impl(filename))
+{
+}
+
+EBOOKMappedFileStream::~EBOOKMappedFileStream()
+{
+  delete m_impl;
+}
+
+bool EBOOKMappedFileStream::isOpen() const
+{
+  return m_impl->m_open;
+}
+
+bool EBOOKMappedFileStream::isStructured()
+{
+  return false;
+}
+
+unsigned EBOOKMappedFileStream::subStreamCount()
+{
+  return 0;
+}
+
+const char *EBOOKMappedFileStream::subStreamName(unsigned)
+{
+  return nullptr;
+}
+
+bool EBOOKMappedFileStream::existsSubStream(const char *)
+{
+  return false;
+}
+
+librevenge::RVNGInputStream *EBOOKMappedFileStream::getSubStreamByName(const char *)
+{
+  return nullptr;
+}
+
+librevenge::RVNGInputStream *EBOOKMappedFileStream::getSubStreamById(unsigned)
+{
+  return nullptr;
+}
+
+const unsigned char *EBOOKMappedFileStream::read(unsigned long numBytes, unsigned long &numBytesRead)
+{
+  numBytesRead = 0;
+
+  if ((0 == numBytes) || (m_impl->m_length == m_impl->m_pos))
+    return nullptr;
+
+  const unsigned long avail = static_cast<unsigned long>(m_impl->m_length - m_impl->m_pos);
+  if (numBytes > avail)
+    numBytes = avail;
+
+  const long oldPos = m_impl->m_pos;
+  m_impl->m_pos += static_cast<long>(numBytes);
+
+  numBytesRead = numBytes;
+  return m_impl->m_data + oldPos;
+}
+
+int EBOOKMappedFileStream::seek(const long offset, librevenge::RVNG_SEEK_TYPE seekType)
+{
+  long pos = 0;
+  switch (seekType)
+  {
+  case librevenge::RVNG_SEEK_SET :
+    pos = offset;
+    break;
+  case librevenge::RVNG_SEEK_CUR :
+    pos = offset + m_impl->m_pos;
+    break;
+  case librevenge::RVNG_SEEK_END :
+    pos = offset + m_impl->m_length;
+    break;
+  default :
+    return -1;
+  }
+
+  if ((pos < 0) || (pos > m_impl->m_length))
+    return 1;
+
+  m_impl->m_pos = pos;
+  return 0;
+}
+
+long EBOOKMappedFileStream::tell()
+{
+  return m_impl->m_pos;
+}
+
+bool EBOOKMappedFileStream::isEnd()
+{
+  return m_impl->m_length == m_impl->m_pos;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
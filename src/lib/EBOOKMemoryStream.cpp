@@ -15,24 +15,58 @@ namespace libebook
 {
 
 EBOOKMemoryStream::EBOOKMemoryStream()
-  : m_data()
+  : m_buffer()
+  , m_data(nullptr)
   , m_length(0)
   , m_pos(0)
 {
 }
 
-EBOOKMemoryStream::EBOOKMemoryStream(const unsigned char *data, unsigned length)
-  : m_data()
+EBOOKMemoryStream::EBOOKMemoryStream(const unsigned char *data, unsigned length, const DataOwnership ownership)
+  : m_buffer()
+  , m_data(nullptr)
   , m_length((long) length)
   , m_pos(0)
 {
   if (0 < length)
   {
-    m_data.reset(new unsigned char[length]);
-    std::copy(data, data + length, m_data.get());
+    if (DATA_OWNERSHIP_BORROW == ownership)
+    {
+      m_data = data;
+    }
+    else
+    {
+      unsigned char *const buffer = new unsigned char[length];
+      m_buffer.reset(buffer, std::default_delete<unsigned char[]>());
+      std::copy(data, data + length, buffer);
+      m_data = buffer;
+    }
   }
 }
 
+EBOOKMemoryStream::EBOOKMemoryStream(std::vector<unsigned char> &&data)
+  : m_buffer()
+  , m_data(nullptr)
+  , m_length((long) data.size())
+  , m_pos(0)
+{
+  if (!data.empty())
+  {
+    const std::shared_ptr<std::vector<unsigned char> > buffer(new std::vector<unsigned char>());
+    buffer->swap(data);
+    m_buffer = std::shared_ptr<const unsigned char>(buffer, &(*buffer)[0]);
+    m_data = m_buffer.get();
+  }
+}
+
+EBOOKMemoryStream::EBOOKMemoryStream(const std::shared_ptr<const unsigned char> &data, const unsigned length)
+  : m_buffer(data)
+  , m_data(data.get())
+  , m_length(data ? (long) length : 0)
+  , m_pos(0)
+{
+}
+
 EBOOKMemoryStream::~EBOOKMemoryStream()
 {
 }
@@ -81,7 +115,7 @@ const unsigned char *EBOOKMemoryStream::read(unsigned long numBytes, unsigned lo
   m_pos += numBytes;
 
   numBytesRead = numBytes;
-  return m_data.get() + oldPos;
+  return m_data + oldPos;
 }
 catch (...)
 {
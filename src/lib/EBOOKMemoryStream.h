@@ -11,6 +11,7 @@
 #define EBOOKMEMORYSTREAM_H_INCLUDED
 
 #include <memory>
+#include <vector>
 
 #include <librevenge-stream/librevenge-stream.h>
 
@@ -23,9 +24,31 @@ class EBOOKMemoryStream : public librevenge::RVNGInputStream
   EBOOKMemoryStream(const EBOOKMemoryStream &other);
   EBOOKMemoryStream &operator=(const EBOOKMemoryStream &other);
 
+public:
+  /** Determine what happens with data passed to the constructor.
+    */
+  enum DataOwnership
+  {
+    DATA_OWNERSHIP_COPY, //< the data are copied
+    DATA_OWNERSHIP_BORROW //< the data are used directly and must outlive the stream
+  };
+
 public:
   EBOOKMemoryStream();
-  EBOOKMemoryStream(const unsigned char *data, unsigned length);
+  EBOOKMemoryStream(const unsigned char *data, unsigned length, DataOwnership ownership = DATA_OWNERSHIP_COPY);
+
+  /** Create a stream taking over the content of a vector.
+    *
+    * @arg[in] data the data
+    */
+  explicit EBOOKMemoryStream(std::vector<unsigned char> &&data);
+
+  /** Create a stream sharing a buffer.
+    *
+    * @arg[in] data the buffer
+    * @arg[in] length the length of the buffer
+    */
+  EBOOKMemoryStream(const std::shared_ptr<const unsigned char> &data, unsigned length);
   ~EBOOKMemoryStream() override;
 
   bool isStructured() override;
@@ -41,7 +64,8 @@ public:
   bool isEnd() override;
 
 private:
-  std::unique_ptr<unsigned char[]> m_data;
+  std::shared_ptr<const unsigned char> m_buffer; //< owner of the data, if the data are not borrowed
+  const unsigned char *m_data;
   const long m_length;
   long m_pos;
 };
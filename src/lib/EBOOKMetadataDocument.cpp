@@ -0,0 +1,273 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EBOOKMetadataDocument.h"
+
+namespace libebook
+{
+
+EBOOKMetadataDocument::EBOOKMetadataDocument(librevenge::RVNGTextInterface &document)
+  : m_document(document)
+{
+}
+
+EBOOKMetadataDocument::~EBOOKMetadataDocument()
+{
+}
+
+void EBOOKMetadataDocument::setDocumentMetaData(const librevenge::RVNGPropertyList &propList)
+{
+  m_document.setDocumentMetaData(propList);
+}
+
+void EBOOKMetadataDocument::startDocument(const librevenge::RVNGPropertyList &propList)
+{
+  m_document.startDocument(propList);
+}
+
+void EBOOKMetadataDocument::endDocument()
+{
+  m_document.endDocument();
+}
+
+void EBOOKMetadataDocument::defineEmbeddedFont(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::definePageStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::openPageSpan(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closePageSpan()
+{
+}
+
+void EBOOKMetadataDocument::openHeader(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeHeader()
+{
+}
+
+void EBOOKMetadataDocument::openFooter(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeFooter()
+{
+}
+
+void EBOOKMetadataDocument::defineParagraphStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::openParagraph(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeParagraph()
+{
+}
+
+void EBOOKMetadataDocument::defineCharacterStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::openSpan(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeSpan()
+{
+}
+
+void EBOOKMetadataDocument::openLink(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeLink()
+{
+}
+
+void EBOOKMetadataDocument::defineSectionStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::openSection(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeSection()
+{
+}
+
+void EBOOKMetadataDocument::insertTab()
+{
+}
+
+void EBOOKMetadataDocument::insertSpace()
+{
+}
+
+void EBOOKMetadataDocument::insertText(const librevenge::RVNGString &)
+{
+}
+
+void EBOOKMetadataDocument::insertLineBreak()
+{
+}
+
+void EBOOKMetadataDocument::insertField(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::openOrderedListLevel(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::openUnorderedListLevel(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeOrderedListLevel()
+{
+}
+
+void EBOOKMetadataDocument::closeUnorderedListLevel()
+{
+}
+
+void EBOOKMetadataDocument::openListElement(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeListElement()
+{
+}
+
+void EBOOKMetadataDocument::openFootnote(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeFootnote()
+{
+}
+
+void EBOOKMetadataDocument::openEndnote(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeEndnote()
+{
+}
+
+void EBOOKMetadataDocument::openComment(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeComment()
+{
+}
+
+void EBOOKMetadataDocument::openTextBox(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeTextBox()
+{
+}
+
+void EBOOKMetadataDocument::openTable(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::openTableRow(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeTableRow()
+{
+}
+
+void EBOOKMetadataDocument::openTableCell(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeTableCell()
+{
+}
+
+void EBOOKMetadataDocument::insertCoveredTableCell(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeTable()
+{
+}
+
+void EBOOKMetadataDocument::openFrame(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeFrame()
+{
+}
+
+void EBOOKMetadataDocument::openGroup(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::closeGroup()
+{
+}
+
+void EBOOKMetadataDocument::defineGraphicStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::drawRectangle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::drawEllipse(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::drawPolygon(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::drawPolyline(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::drawPath(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::drawConnector(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::insertBinaryObject(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKMetadataDocument::insertEquation(const librevenge::RVNGPropertyList &)
+{
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
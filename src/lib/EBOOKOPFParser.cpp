@@ -686,6 +686,20 @@ void EBOOKOPFParser::parse()
   }
 }
 
+void EBOOKOPFParser::parseMetadata()
+{
+  Package package;
+
+  OPFParserImpl parser(m_input, package);
+  parser.parse();
+
+  if (!package.spine.empty())
+  {
+    m_document->startDocument(package.metadata);
+    m_document->endDocument();
+  }
+}
+
 bool EBOOKOPFParser::findOPFStream(const RVNGInputStreamPtr_t &package, unsigned &stream)
 {
   return findSubStreamByExt(package, ".opf", stream);
@@ -36,6 +36,12 @@ public:
 
   void parse();
 
+  /** Parse only the package metadata.
+    *
+    * The spine items are not read.
+    */
+  void parseMetadata();
+
   static bool findOPFStream(const RVNGInputStreamPtr_t &package, unsigned &stream);
 
 private:
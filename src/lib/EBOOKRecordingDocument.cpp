@@ -0,0 +1,305 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EBOOKOutputElements.h"
+#include "EBOOKRecordingDocument.h"
+
+namespace libebook
+{
+
+EBOOKRecordingDocument::EBOOKRecordingDocument(EBOOKOutputElements &elements)
+  : m_elements(elements)
+{
+}
+
+EBOOKRecordingDocument::~EBOOKRecordingDocument()
+{
+}
+
+void EBOOKRecordingDocument::setDocumentMetaData(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::startDocument(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::endDocument()
+{
+}
+
+void EBOOKRecordingDocument::defineEmbeddedFont(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::definePageStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::openPageSpan(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenPageSpan(propList);
+}
+
+void EBOOKRecordingDocument::closePageSpan()
+{
+  m_elements.addClosePageSpan();
+}
+
+void EBOOKRecordingDocument::openHeader(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::closeHeader()
+{
+}
+
+void EBOOKRecordingDocument::openFooter(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::closeFooter()
+{
+}
+
+void EBOOKRecordingDocument::defineParagraphStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::openParagraph(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenParagraph(propList);
+}
+
+void EBOOKRecordingDocument::closeParagraph()
+{
+  m_elements.addCloseParagraph();
+}
+
+void EBOOKRecordingDocument::defineCharacterStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::openSpan(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenSpan(propList);
+}
+
+void EBOOKRecordingDocument::closeSpan()
+{
+  m_elements.addCloseSpan();
+}
+
+void EBOOKRecordingDocument::openLink(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenLink(propList);
+}
+
+void EBOOKRecordingDocument::closeLink()
+{
+  m_elements.addCloseLink();
+}
+
+void EBOOKRecordingDocument::defineSectionStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::openSection(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenSection(propList);
+}
+
+void EBOOKRecordingDocument::closeSection()
+{
+  m_elements.addCloseSection();
+}
+
+void EBOOKRecordingDocument::insertTab()
+{
+  m_elements.addInsertTab();
+}
+
+void EBOOKRecordingDocument::insertSpace()
+{
+  m_elements.addInsertSpace();
+}
+
+void EBOOKRecordingDocument::insertText(const librevenge::RVNGString &text)
+{
+  m_elements.addInsertText(text);
+}
+
+void EBOOKRecordingDocument::insertLineBreak()
+{
+  m_elements.addInsertLineBreak();
+}
+
+void EBOOKRecordingDocument::insertField(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::openOrderedListLevel(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenOrderedListLevel(propList);
+}
+
+void EBOOKRecordingDocument::openUnorderedListLevel(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenUnorderedListLevel(propList);
+}
+
+void EBOOKRecordingDocument::closeOrderedListLevel()
+{
+  m_elements.addCloseOrderedListLevel();
+}
+
+void EBOOKRecordingDocument::closeUnorderedListLevel()
+{
+  m_elements.addCloseUnorderedListLevel();
+}
+
+void EBOOKRecordingDocument::openListElement(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenListElement(propList);
+}
+
+void EBOOKRecordingDocument::closeListElement()
+{
+  m_elements.addCloseListElement();
+}
+
+void EBOOKRecordingDocument::openFootnote(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenFootnote(propList);
+}
+
+void EBOOKRecordingDocument::closeFootnote()
+{
+  m_elements.addCloseFootnote();
+}
+
+void EBOOKRecordingDocument::openEndnote(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenEndnote(propList);
+}
+
+void EBOOKRecordingDocument::closeEndnote()
+{
+  m_elements.addCloseEndnote();
+}
+
+void EBOOKRecordingDocument::openComment(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::closeComment()
+{
+}
+
+void EBOOKRecordingDocument::openTextBox(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::closeTextBox()
+{
+}
+
+void EBOOKRecordingDocument::openTable(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenTable(propList);
+}
+
+void EBOOKRecordingDocument::openTableRow(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenTableRow(propList);
+}
+
+void EBOOKRecordingDocument::closeTableRow()
+{
+  m_elements.addCloseTableRow();
+}
+
+void EBOOKRecordingDocument::openTableCell(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenTableCell(propList);
+}
+
+void EBOOKRecordingDocument::closeTableCell()
+{
+  m_elements.addCloseTableCell();
+}
+
+void EBOOKRecordingDocument::insertCoveredTableCell(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addInsertCoveredTableCell(propList);
+}
+
+void EBOOKRecordingDocument::closeTable()
+{
+  m_elements.addCloseTable();
+}
+
+void EBOOKRecordingDocument::openFrame(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addOpenFrame(propList);
+}
+
+void EBOOKRecordingDocument::closeFrame()
+{
+  m_elements.addCloseFrame();
+}
+
+void EBOOKRecordingDocument::openGroup(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::closeGroup()
+{
+}
+
+void EBOOKRecordingDocument::defineGraphicStyle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::drawRectangle(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::drawEllipse(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::drawPolygon(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::drawPolyline(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::drawPath(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::drawConnector(const librevenge::RVNGPropertyList &)
+{
+}
+
+void EBOOKRecordingDocument::insertBinaryObject(const librevenge::RVNGPropertyList &propList)
+{
+  m_elements.addInsertBinaryObject(propList);
+}
+
+void EBOOKRecordingDocument::insertEquation(const librevenge::RVNGPropertyList &)
+{
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
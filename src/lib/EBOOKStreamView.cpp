@@ -15,7 +15,7 @@
 namespace libebook
 {
 
-EBOOKStreamView::EBOOKStreamView(librevenge::RVNGInputStream *const stream, const long begin, const long end)
+EBOOKStreamView::EBOOKStreamView(librevenge::RVNGInputStream *const stream, const long begin, const long end, const Bounds bounds)
   : m_stream(stream)
   , m_begin(begin)
   , m_end(end)
@@ -23,7 +23,7 @@ EBOOKStreamView::EBOOKStreamView(librevenge::RVNGInputStream *const stream, cons
   if (m_end < m_begin)
     throw EndOfStreamException();
   // better to let the stream die unborn than to be inconsistent
-  if ((0 != m_stream->seek(m_end, librevenge::RVNG_SEEK_SET)) || (m_stream->tell() != m_end))
+  if ((BOUNDS_CHECK == bounds) && ((0 != m_stream->seek(m_end, librevenge::RVNG_SEEK_SET)) || (m_stream->tell() != m_end)))
     throw EndOfStreamException();
   if ((0 != m_stream->seek(m_begin, librevenge::RVNG_SEEK_SET)) || (m_stream->tell() != m_begin))
     throw EndOfStreamException();
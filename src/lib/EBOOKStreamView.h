@@ -29,7 +29,16 @@ class EBOOKStreamView : public librevenge::RVNGInputStream
   EBOOKStreamView &operator=(const EBOOKStreamView &other);
 
 public:
-  EBOOKStreamView(librevenge::RVNGInputStream *stream, long begin, long end);
+  /** Determine if the bounds passed to the constructor are checked.
+    */
+  enum Bounds
+  {
+    BOUNDS_CHECK, //< the stream is checked to contain the bounds
+    BOUNDS_TRUSTED //< the bounds are known to lie inside the stream
+  };
+
+public:
+  EBOOKStreamView(librevenge::RVNGInputStream *stream, long begin, long end, Bounds bounds = BOUNDS_CHECK);
   ~EBOOKStreamView() override;
 
   bool isStructured() override;
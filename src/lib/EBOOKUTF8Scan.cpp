@@ -0,0 +1,231 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define EBOOK_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define EBOOK_SCAN_SSE2 1
+#endif
+
+#include "EBOOKUTF8Scan.h"
+
+namespace libebook
+{
+
+namespace
+{
+
+bool isContinuation(const unsigned char c)
+{
+  return 0x80 == (c & 0xc0);
+}
+
+char *appendUTF8(const uint32_t c, char *out)
+{
+  if (0x80 > c)
+  {
+    *out++ = char(c);
+  }
+  else if (0x800 > c)
+  {
+    *out++ = char(0xc0 | (c >> 6));
+    *out++ = char(0x80 | (c & 0x3f));
+  }
+  else if (0x10000 > c)
+  {
+    *out++ = char(0xe0 | (c >> 12));
+    *out++ = char(0x80 | ((c >> 6) & 0x3f));
+    *out++ = char(0x80 | (c & 0x3f));
+  }
+  else
+  {
+    *out++ = char(0xf0 | (c >> 18));
+    *out++ = char(0x80 | ((c >> 12) & 0x3f));
+    *out++ = char(0x80 | ((c >> 6) & 0x3f));
+    *out++ = char(0x80 | (c & 0x3f));
+  }
+  return out;
+}
+
+const uint32_t REPLACEMENT_CHARACTER = 0xfffd;
+
+}
+
+unsigned long findNonASCII(const char *const text, const unsigned long length)
+{
+  unsigned long pos = 0;
+
+#if defined(EBOOK_SCAN_AVX2)
+  for (; length - pos >= 32; pos += 32)
+  {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+    if (0 != _mm256_movemask_epi8(block))
+      break;
+  }
+#elif defined(EBOOK_SCAN_SSE2)
+  for (; length - pos >= 16; pos += 16)
+  {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+    if (0 != _mm_movemask_epi8(block))
+      break;
+  }
+#else
+  for (; length - pos >= 8; pos += 8)
+  {
+    uint64_t block;
+    std::memcpy(&block, text + pos, sizeof(block));
+    if (0 != (block & 0x8080808080808080ull))
+      break;
+  }
+#endif
+
+  // find the exact position in the rest
+  for (; length != pos; ++pos)
+  {
+    if (0 != (static_cast<unsigned char>(text[pos]) & 0x80))
+      break;
+  }
+
+  return pos;
+}
+
+bool isASCII(const char *const text, const unsigned long length)
+{
+  return length == findNonASCII(text, length);
+}
+
+bool isValidUTF8(const char *const text, const unsigned long length)
+{
+  const auto *const data = reinterpret_cast<const unsigned char *>(text);
+
+  unsigned long pos = findNonASCII(text, length);
+  while (length != pos)
+  {
+    const unsigned char c = data[pos];
+    unsigned long trail = 0;
+    unsigned char min = 0x80;
+    unsigned char max = 0xbf;
+
+    if (0xc2 > c)
+      return false; // a continuation byte or an overlong 2-byte form
+    else if (0xe0 > c)
+      trail = 1;
+    else if (0xf0 > c)
+    {
+      trail = 2;
+      if (0xe0 == c)
+        min = 0xa0; // overlong
+      else if (0xed == c)
+        max = 0x9f; // surrogates
+    }
+    else if (0xf5 > c)
+    {
+      trail = 3;
+      if (0xf0 == c)
+        min = 0x90; // overlong
+      else if (0xf4 == c)
+        max = 0x8f; // above U+10FFFF
+    }
+    else
+      return false;
+
+    if (length - pos <= trail)
+      return false;
+    if ((min > data[pos + 1]) || (max < data[pos + 1]))
+      return false;
+    for (unsigned long i = 2; i <= trail; ++i)
+    {
+      if (!isContinuation(data[pos + i]))
+        return false;
+    }
+
+    pos += trail + 1;
+    pos += findNonASCII(text + pos, length - pos);
+  }
+
+  return true;
+}
+
+void convertUTF16LEToUTF8(const unsigned char *const data, const unsigned long length, std::vector<char> &out)
+{
+  // every unit takes at most 3 bytes, and so does the replacement of an
+  // odd byte at the end
+  out.resize((length / 2) * 3 + 3);
+  char *const begin = &out[0];
+  char *current = begin;
+
+  const unsigned long end = length & ~1ul;
+  unsigned long pos = 0;
+  bool truncated = false; // an unpaired surrogate at the end
+
+  while (end != pos)
+  {
+#if defined(EBOOK_SCAN_AVX2) || defined(EBOOK_SCAN_SSE2)
+    const __m128i nonASCIIMask = _mm_set1_epi16(static_cast<short>(0xff80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; end - pos >= 16; pos += 16)
+    {
+      const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+      const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(block, nonASCIIMask), zero);
+      if (0xffff != _mm_movemask_epi8(ascii))
+        break;
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(current), _mm_packus_epi16(block, block));
+      current += 8;
+    }
+    if (end == pos)
+      break;
+#endif
+
+    const uint32_t unit = uint32_t(data[pos]) | (uint32_t(data[pos + 1]) << 8);
+    pos += 2;
+
+    if ((0xd800 > unit) || (0xdfff < unit))
+    {
+      current = appendUTF8(unit, current);
+    }
+    else if (0xdc00 <= unit)
+    {
+      current = appendUTF8(REPLACEMENT_CHARACTER, current);
+    }
+    else if (end == pos)
+    {
+      current = appendUTF8(REPLACEMENT_CHARACTER, current);
+      truncated = true;
+    }
+    else
+    {
+      const uint32_t low = uint32_t(data[pos]) | (uint32_t(data[pos + 1]) << 8);
+      if ((0xdc00 <= low) && (0xdfff >= low))
+      {
+        pos += 2;
+        current = appendUTF8(0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00), current);
+      }
+      else
+      {
+        current = appendUTF8(REPLACEMENT_CHARACTER, current);
+      }
+    }
+  }
+
+  // ICU replaces an unpaired surrogate together with the odd byte
+  if ((end != length) && !truncated)
+    current = appendUTF8(REPLACEMENT_CHARACTER, current);
+
+  out.resize(static_cast<std::vector<char>::size_type>(current - begin));
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
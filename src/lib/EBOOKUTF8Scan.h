@@ -0,0 +1,56 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef EBOOKUTF8SCAN_H_INCLUDED
+#define EBOOKUTF8SCAN_H_INCLUDED
+
+#include <vector>
+
+namespace libebook
+{
+
+/** Find the first byte that is not 7-bit ASCII.
+  *
+  * The text is checked by 16 or 32 bytes at once where SSE2 or AVX2
+  * are available.
+  *
+  * @arg[in] text the text
+  * @arg[in] length the length of the text
+  * @return the position of the byte, or @c length if there is none
+  */
+unsigned long findNonASCII(const char *text, unsigned long length);
+
+/** Check if a text consists of 7-bit ASCII characters only.
+  */
+bool isASCII(const char *text, unsigned long length);
+
+/** Check if a text is valid UTF-8.
+  *
+  * Overlong forms, surrogates and code points above U+10FFFF are
+  * rejected, like ICU does.
+  */
+bool isValidUTF8(const char *text, unsigned long length);
+
+/** Convert UTF-16LE text to UTF-8.
+  *
+  * Runs of ASCII characters are converted 8 at once where SSE2 is
+  * available. Unpaired surrogates and a trailing odd byte are replaced
+  * by U+FFFD, like ICU does.
+  *
+  * @arg[in] data the text
+  * @arg[in] length the length of the text in bytes
+  * @arg[out] out the converted text. Its capacity is reused.
+  */
+void convertUTF16LEToUTF8(const unsigned char *data, unsigned long length, std::vector<char> &out);
+
+}
+
+#endif // EBOOKUTF8SCAN_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -7,6 +7,10 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "libebook_utils.h"
@@ -28,17 +32,307 @@ class StreamException
 {
 };
 
+const unsigned long INPUT_CHUNK_SIZE = 0x4000;
+const unsigned long OUTPUT_CHUNK_SIZE = 0x4000;
+
+/** A stream converting its input to UTF-8 on demand.
+  *
+  * This works like EBOOKZlibStream: only the converted data after the
+  * current position and a chunk before it are kept. Seeking back before
+  * them converts the input again from the start.
+  */
+class ConvertingStream : public librevenge::RVNGInputStream
+{
+  // disable copying
+  ConvertingStream(const ConvertingStream &other);
+  ConvertingStream &operator=(const ConvertingStream &other);
+
+public:
+  ConvertingStream(librevenge::RVNGInputStream *input, std::unique_ptr<EBOOKCharsetConverter> converter);
+
+  bool isStructured() override;
+  unsigned subStreamCount() override;
+  const char *subStreamName(unsigned id) override;
+  bool existsSubStream(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamByName(const char *name) override;
+  RVNGInputStream *getSubStreamById(unsigned id) override;
+
+  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
+  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
+  long tell() override;
+  bool isEnd() override;
+
+private:
+  /** Convert until the data up to @c end are available.
+    *
+    * @arg[in] end the end of the needed data
+    * @arg[in] keep the start of the data that must not be dropped
+    */
+  void fill(unsigned long end, unsigned long keep);
+
+  /** Fill, but treat a conversion error as the end of the data.
+    */
+  void fillAvailable(unsigned long end, unsigned long keep);
+
+  void restart();
+
+private:
+  librevenge::RVNGInputStream *const m_input;
+  const std::unique_ptr<EBOOKCharsetConverter> m_converter;
+  const long m_inputBegin; //< the start of the data in the input
+  long m_inputPos; //< the first input byte that has not been converted yet
+  vector<unsigned char> m_buffer; //< the converted data that are kept
+  unsigned long m_bufferStart; //< the position of the first byte of m_buffer
+  unsigned long m_pos;
+  bool m_finished; //< all the data have been converted
+};
+
+ConvertingStream::ConvertingStream(librevenge::RVNGInputStream *const input, std::unique_ptr<EBOOKCharsetConverter> converter)
+  : m_input(input)
+  , m_converter(std::move(converter))
+  , m_inputBegin(input->tell())
+  , m_inputPos(m_inputBegin)
+  , m_buffer()
+  , m_bufferStart(0)
+  , m_pos(0)
+  , m_finished(false)
+{
+  assert(m_converter);
+
+  // convert the first chunk, so broken data are detected early
+  fill(1, 0);
+}
+
+bool ConvertingStream::isStructured()
+{
+  return false;
+}
+
+unsigned ConvertingStream::subStreamCount()
+{
+  return 0;
+}
+
+const char *ConvertingStream::subStreamName(unsigned)
+{
+  return nullptr;
+}
+
+bool ConvertingStream::existsSubStream(const char *)
+{
+  return false;
+}
+
+librevenge::RVNGInputStream *ConvertingStream::getSubStreamByName(const char *)
+{
+  return nullptr;
+}
+
+librevenge::RVNGInputStream *ConvertingStream::getSubStreamById(unsigned)
+{
+  return nullptr;
+}
+
+const unsigned char *ConvertingStream::read(const unsigned long numBytes, unsigned long &numBytesRead) try
+{
+  numBytesRead = 0;
+
+  if (0 == numBytes)
+    return nullptr;
+
+  if (m_pos < m_bufferStart)
+    restart();
+
+  const unsigned long end = (ULONG_MAX - m_pos < numBytes) ? ULONG_MAX : m_pos + numBytes;
+  fillAvailable(end, m_pos);
+
+  const unsigned long bufferEnd = m_bufferStart + m_buffer.size();
+  if (bufferEnd <= m_pos)
+    return nullptr;
+
+  numBytesRead = std::min(numBytes, bufferEnd - m_pos);
+  const unsigned char *const data = &m_buffer[m_pos - m_bufferStart];
+  m_pos += numBytesRead;
+  return data;
+}
+catch (...)
+{
+  return nullptr;
+}
+
+int ConvertingStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType) try
+{
+  long pos = 0;
+  switch (seekType)
+  {
+  case librevenge::RVNG_SEEK_SET :
+    pos = offset;
+    break;
+  case librevenge::RVNG_SEEK_CUR :
+    pos = offset + static_cast<long>(m_pos);
+    break;
+  case librevenge::RVNG_SEEK_END :
+    if (m_pos < m_bufferStart)
+      restart();
+    // keep the data after the current position, so seeking back is cheap
+    fillAvailable(ULONG_MAX, m_pos);
+    pos = offset + static_cast<long>(m_bufferStart + m_buffer.size());
+    break;
+  default :
+    return -1;
+  }
+
+  if (pos < 0)
+    return 1;
+
+  const auto newPos = static_cast<unsigned long>(pos);
+  if (newPos < m_bufferStart)
+    restart();
+  fillAvailable(newPos, std::min(newPos, m_pos));
+
+  if (newPos > m_bufferStart + m_buffer.size())
+    return 1;
+
+  m_pos = newPos;
+  return 0;
+}
+catch (...)
+{
+  return -1;
+}
+
+long ConvertingStream::tell()
+{
+  return static_cast<long>(m_pos);
+}
+
+bool ConvertingStream::isEnd() try
+{
+  if (m_pos < m_bufferStart)
+    return false;
+
+  fillAvailable(m_pos + 1, m_pos);
+
+  return m_bufferStart + m_buffer.size() == m_pos;
+}
+catch (...)
+{
+  return true;
+}
+
+void ConvertingStream::fill(const unsigned long end, const unsigned long keep)
+{
+  assert(keep >= m_bufferStart);
+
+  while (!m_finished && (m_bufferStart + m_buffer.size() < end))
+  {
+    // drop the data that are not needed anymore, but keep a chunk
+    // before the current position, so short seeks back are cheap
+    const unsigned long unneeded = std::min<unsigned long>(keep - m_bufferStart, m_buffer.size());
+    if (2 * OUTPUT_CHUNK_SIZE <= unneeded)
+    {
+      const unsigned long dropped = unneeded - OUTPUT_CHUNK_SIZE;
+      m_buffer.erase(m_buffer.begin(), m_buffer.begin() + long(dropped));
+      m_bufferStart += dropped;
+    }
+
+    unsigned long numBytesRead = 0;
+    const unsigned char *input = nullptr;
+    if (0 == m_input->seek(m_inputPos, librevenge::RVNG_SEEK_SET))
+      input = m_input->read(INPUT_CHUNK_SIZE, numBytesRead);
+    if (!input)
+      numBytesRead = 0;
+    const bool last = (INPUT_CHUNK_SIZE > numBytesRead) || m_input->isEnd();
+
+    const char noInput = 0;
+    const char *const inBegin = input ? reinterpret_cast<const char *>(input) : &noInput;
+    const char *in = inBegin;
+    const char *const inEnd = inBegin + numBytesRead;
+
+    const vector<unsigned char>::size_type size = m_buffer.size();
+    m_buffer.resize(size + OUTPUT_CHUNK_SIZE);
+    char *const outBegin = reinterpret_cast<char *>(&m_buffer[size]);
+    char *out = outBegin;
+    char *const outEnd = outBegin + OUTPUT_CHUNK_SIZE;
+
+    const bool converted = m_converter->convertPart(in, inEnd, out, outEnd, last);
+
+    m_buffer.resize(size + static_cast<unsigned long>(out - outBegin));
+    // the input buffer is only valid until the next read, so unused
+    // input is read again the next time
+    m_inputPos += long(in - inBegin);
+
+    if (!converted)
+    {
+      m_finished = true;
+      throw StreamException();
+    }
+    if (last && (inEnd == in) && (outEnd != out))
+      m_finished = true;
+  }
+}
+
+void ConvertingStream::fillAvailable(const unsigned long end, const unsigned long keep)
+{
+  try
+  {
+    fill(end, keep);
+  }
+  catch (const StreamException &)
+  {
+    // use what has been converted so far
+  }
+}
+
+void ConvertingStream::restart()
+{
+  m_converter->reset();
+  m_inputPos = m_inputBegin;
+  m_buffer.clear();
+  m_bufferStart = 0;
+  m_finished = false;
+}
+
 }
 
-EBOOKUTF8Stream::EBOOKUTF8Stream(librevenge::RVNGInputStream *const strm, EBOOKCharsetConverter *converter)
+EBOOKUTF8Stream::EBOOKUTF8Stream(librevenge::RVNGInputStream *const strm, EBOOKCharsetConverter *converter, const Mode mode)
   : m_stream()
 {
   if (!strm)
     throw StreamException();
 
+  const long begin = strm->tell();
+
+  if (MODE_STREAMING == mode)
+  {
+    // The input is not seeked to its end, as a lazy input (e.g.,
+    // EBOOKZlibStream) would have to produce all of its content for that.
+    if (strm->isEnd())
+    {
+      m_stream.reset(new EBOOKMemoryStream());
+      return;
+    }
+
+    const char *const encoding = converter ? converter->getEncoding() : nullptr;
+    unique_ptr<EBOOKCharsetConverter> ownConverter(new EBOOKCharsetConverter(encoding));
+    if (!encoding)
+    {
+      unsigned long sampleLength = 0;
+      const auto *const sample = reinterpret_cast<const char *>(strm->read(INPUT_CHUNK_SIZE, sampleLength));
+      if (!sample || (0 == sampleLength) || !ownConverter->guessEncoding(sample, static_cast<unsigned>(sampleLength)))
+        throw StreamException();
+      strm->seek(begin, librevenge::RVNG_SEEK_SET);
+    }
+
+    unique_ptr<ConvertingStream> converted(new ConvertingStream(strm, std::move(ownConverter)));
+    if (converted->isEnd())
+      throw StreamException();
+    m_stream = std::move(converted);
+    return;
+  }
+
   vector<char> data;
 
-  const long begin = strm->tell();
   strm->seek(0, librevenge::RVNG_SEEK_END);
   const long end = strm->tell();
   strm->seek(begin, librevenge::RVNG_SEEK_SET);
@@ -50,6 +344,7 @@ EBOOKUTF8Stream::EBOOKUTF8Stream(librevenge::RVNGInputStream *const strm, EBOOKC
   }
 
   const auto bytesToRead = static_cast<unsigned long>(end - begin);
+
   const auto *const s = reinterpret_cast<const char *>(readNBytes(strm, bytesToRead));
 
   unique_ptr<EBOOKCharsetConverter> createdConverter;
@@ -62,14 +357,13 @@ EBOOKUTF8Stream::EBOOKUTF8Stream(librevenge::RVNGInputStream *const strm, EBOOKC
       throw StreamException();
   }
 
-  data.reserve(static_cast<unsigned>(bytesToRead));
-
-  if (!converter->convertBytes(s, static_cast<unsigned>(bytesToRead), data))
-    throw StreamException();
-  if (data.empty())
+  // text that needs no conversion is copied straight from the input
+  unsigned convertedLength = 0;
+  const char *const converted = converter->convertBytes(s, static_cast<unsigned>(bytesToRead), data, convertedLength);
+  if (!converted || (0 == convertedLength))
     throw StreamException();
 
-  m_stream.reset(new EBOOKMemoryStream(reinterpret_cast<const unsigned char *>(&data[0]), static_cast<unsigned>(data.size())));
+  m_stream.reset(new EBOOKMemoryStream(reinterpret_cast<const unsigned char *>(converted), convertedLength));
 }
 
 EBOOKUTF8Stream::~EBOOKUTF8Stream()
@@ -21,8 +21,36 @@ class EBOOKCharsetConverter;
 
 class EBOOKUTF8Stream : public librevenge::RVNGInputStream
 {
+  // disable copying
+  EBOOKUTF8Stream(const EBOOKUTF8Stream &other);
+  EBOOKUTF8Stream &operator=(const EBOOKUTF8Stream &other);
+
+public:
+  /** Determine when the input is converted.
+    */
+  enum Mode
+  {
+    MODE_CONVERT_ALL, //< the whole input is converted at once
+    MODE_STREAMING //< the input is converted in parts on demand
+  };
+
 public:
-  explicit EBOOKUTF8Stream(librevenge::RVNGInputStream *strm, EBOOKCharsetConverter *converter = nullptr);
+  /** Create a stream of the content of @c strm in UTF-8.
+    *
+    * In streaming mode, the input stream must outlive this stream. The
+    * converter is only used to find the encoding, so it can be destroyed
+    * or used for other conversions after the stream is created. If there
+    * is no converter, the encoding is guessed from the start of the input
+    * instead of the whole input. The input is only read as far as needed,
+    * so lazily produced input (e.g., EBOOKZlibStream) is never produced
+    * as a whole.
+    *
+    * @arg[in] strm the input stream
+    * @arg[in] converter a converter for the encoding of the input, or
+    *   nullptr to guess the encoding
+    * @arg[in] mode the conversion mode
+    */
+  explicit EBOOKUTF8Stream(librevenge::RVNGInputStream *strm, EBOOKCharsetConverter *converter = nullptr, Mode mode = MODE_CONVERT_ALL);
   ~EBOOKUTF8Stream() override;
 
   bool isStructured() override;
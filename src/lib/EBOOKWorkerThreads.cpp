@@ -0,0 +1,37 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "EBOOKWorkerThreads.h"
+
+namespace libebook
+{
+
+EBOOKWorkerThreads::EBOOKWorkerThreads(std::mutex &mutex, std::condition_variable &changed, bool &stopped)
+  : m_mutex(mutex)
+  , m_changed(changed)
+  , m_stopped(stopped)
+  , m_threads()
+{
+}
+
+EBOOKWorkerThreads::~EBOOKWorkerThreads()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_changed.notify_all();
+
+  for (auto &thread : m_threads)
+    thread.join();
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,61 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef EBOOKWORKERTHREADS_H_INCLUDED
+#define EBOOKWORKERTHREADS_H_INCLUDED
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libebook
+{
+
+/** Worker threads that are stopped and joined on destruction.
+  *
+  * This makes sure no worker is left running if the thread that
+  * started them leaves early because of an exception. The workers
+  * must check the @c stopped flag whenever they wake up on the
+  * condition variable.
+  */
+class EBOOKWorkerThreads
+{
+  // disable copying
+  EBOOKWorkerThreads(const EBOOKWorkerThreads &other);
+  EBOOKWorkerThreads &operator=(const EBOOKWorkerThreads &other);
+
+public:
+  /** Create an empty set of workers.
+    *
+    * @arg[in] mutex the mutex guarding @c stopped
+    * @arg[in] changed the condition variable the workers wait on
+    * @arg[in] stopped the flag set on destruction
+    */
+  EBOOKWorkerThreads(std::mutex &mutex, std::condition_variable &changed, bool &stopped);
+  ~EBOOKWorkerThreads();
+
+  template<typename Function>
+  void start(Function function)
+  {
+    m_threads.push_back(std::thread(function));
+  }
+
+private:
+  std::mutex &m_mutex;
+  std::condition_variable &m_changed;
+  bool &m_stopped;
+  std::vector<std::thread> m_threads;
+};
+
+}
+
+#endif // EBOOKWORKERTHREADS_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
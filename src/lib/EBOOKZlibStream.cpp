@@ -7,17 +7,23 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
 #include <cassert>
-#include <vector>
+#include <climits>
 
 #include <zlib.h>
 
+#ifdef WITH_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
 #include "libebook_utils.h"
-#include "EBOOKMemoryStream.h"
 #include "EBOOKZlibStream.h"
 
-using std::vector;
-
 namespace libebook
 {
 
@@ -28,92 +34,46 @@ class ZlibStreamException
 {
 };
 
-EBOOKMemoryStream *getInflatedStream(librevenge::RVNGInputStream *const input)
-{
-  if (0x78 != readU8(input)) // not a zlib stream
-    throw ZlibStreamException();
-
-  const bool uncompressed = Z_NO_COMPRESSION == readU8(input);
-
-  auto begin = (unsigned long) input->tell();
-  input->seek(0, librevenge::RVNG_SEEK_END);
-  auto end = (unsigned long) input->tell();
-  unsigned long compressedSize = end - begin;
-  input->seek((long) begin, librevenge::RVNG_SEEK_SET);
-
-  if (0 == compressedSize) // No data?!
-    throw ZlibStreamException();
-
-  unsigned long numBytesRead = 0;
-  auto *compressedData = const_cast<unsigned char *>(input->read(compressedSize, numBytesRead));
+const unsigned long INPUT_CHUNK_SIZE = 0x4000;
+const unsigned long OUTPUT_CHUNK_SIZE = 0x4000;
 
-  if (uncompressed)
-  {
-    if (numBytesRead != compressedSize)
-      throw ZlibStreamException();
-    return new EBOOKMemoryStream(compressedData, static_cast<unsigned>(compressedSize));
-  }
-  else
-  {
-    int ret;
-    z_stream strm;
-
-    /* allocate inflate state */
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    strm.avail_in = 0;
-    strm.next_in = Z_NULL;
-    ret = inflateInit2(&strm,-MAX_WBITS);
-    if (ret != Z_OK)
-      throw ZlibStreamException();
-
-    strm.avail_in = (unsigned)numBytesRead;
-    strm.next_in = (Bytef *)compressedData;
-    strm.total_out = 0;
-
-    vector<unsigned char> data(2 * compressedSize);
-
-    while (true)
-    {
-      strm.next_out = reinterpret_cast<Bytef *>(&data[strm.total_out]);
-      strm.avail_out = uInt(data.size() - strm.total_out);
-      ret = inflate(&strm, Z_SYNC_FLUSH);
-
-      if (Z_STREAM_END == ret)
-        break;
-      if ((Z_OK == ret) && (0 == strm.avail_in) && (0 < strm.avail_out)) // end of stream too
-        break;
-      if (Z_OK != ret)
-      {
-        (void)inflateEnd(&strm);
-        throw ZlibStreamException();
-      }
-
-      data.resize(data.size() + compressedSize);
-    }
-
-    (void)inflateEnd(&strm);
-
-    return new EBOOKMemoryStream(&data[0], (unsigned) strm.total_out);
-  }
-}
+// deflate cannot compress better than about 1:1032
+const unsigned long MAX_DEFLATE_RATIO = 1032;
 
 }
 
 EBOOKZlibStream::EBOOKZlibStream(librevenge::RVNGInputStream *const stream)
-  : m_stream()
+  : m_input(stream)
+  , m_zstream()
+  , m_inputBegin(0)
+  , m_inputPos(0)
+  , m_buffer()
+  , m_bufferStart(0)
+  , m_pos(0)
+  , m_finished(false)
+  , m_failed(false)
 {
-  assert(stream);
-
-  if (0 != stream->seek(0, librevenge::RVNG_SEEK_SET))
-    throw EndOfStreamException();
+  open(0);
+}
 
-  m_stream.reset(getInflatedStream(stream));
+EBOOKZlibStream::EBOOKZlibStream(librevenge::RVNGInputStream *const stream, const unsigned long size)
+  : m_input(stream)
+  , m_zstream()
+  , m_inputBegin(0)
+  , m_inputPos(0)
+  , m_buffer()
+  , m_bufferStart(0)
+  , m_pos(0)
+  , m_finished(false)
+  , m_failed(false)
+{
+  open(size);
 }
 
 EBOOKZlibStream::~EBOOKZlibStream()
 {
+  if (bool(m_zstream))
+    (void) inflateEnd(m_zstream.get());
 }
 
 bool EBOOKZlibStream::isStructured()
@@ -146,24 +106,324 @@ librevenge::RVNGInputStream *EBOOKZlibStream::getSubStreamById(unsigned)
   return nullptr;
 }
 
-const unsigned char *EBOOKZlibStream::read(const unsigned long numBytes, unsigned long &numBytesRead)
+void EBOOKZlibStream::open(const unsigned long size)
 {
-  return m_stream->read(numBytes, numBytesRead);
+  assert(m_input);
+
+  if (0 != m_input->seek(0, librevenge::RVNG_SEEK_SET))
+    throw EndOfStreamException();
+
+  if (0x78 != readU8(m_input)) // not a zlib stream
+    throw ZlibStreamException();
+
+  const bool uncompressed = Z_NO_COMPRESSION == readU8(m_input);
+
+  m_inputBegin = m_inputPos = m_input->tell();
+  if (m_input->isEnd()) // No data?!
+    throw ZlibStreamException();
+
+  if (uncompressed)
+  {
+    const unsigned long length = getRemainingLength(m_input);
+    const unsigned char *const data = readNBytes(m_input, length);
+    m_buffer.assign(data, data + length);
+    m_finished = true;
+    return;
+  }
+
+  if ((0 < size) && inflateAll(size))
+    return;
+
+  m_zstream.reset(new z_stream());
+  m_zstream->zalloc = Z_NULL;
+  m_zstream->zfree = Z_NULL;
+  m_zstream->opaque = Z_NULL;
+  m_zstream->avail_in = 0;
+  m_zstream->next_in = Z_NULL;
+  if (Z_OK != inflateInit2(m_zstream.get(), -MAX_WBITS))
+  {
+    m_zstream.reset();
+    throw ZlibStreamException();
+  }
+
+  // inflate the first chunk, so broken data are detected early
+  try
+  {
+    fill(1, 0);
+  }
+  catch (...)
+  {
+    (void) inflateEnd(m_zstream.get());
+    throw;
+  }
 }
 
-int EBOOKZlibStream::seek(long offset, const librevenge::RVNG_SEEK_TYPE seekType)
+bool EBOOKZlibStream::inflateAll(const unsigned long size)
 {
-  return m_stream->seek(offset, seekType);
+  const unsigned long length = getRemainingLength(m_input);
+  if ((size / MAX_DEFLATE_RATIO > length) || (UINT_MAX <= size))
+  {
+    EBOOK_DEBUG_MSG(("expected size %lu of inflated data is not possible\n", size));
+    return false;
+  }
+  const unsigned char *const data = readNBytes(m_input, length);
+
+  // allow one byte more, to find out if the size is too small
+  m_buffer.resize(size + 1);
+
+  bool done = false;
+
+#ifdef WITH_LIBDEFLATE
+  libdeflate_decompressor *const decompressor = libdeflate_alloc_decompressor();
+  if (decompressor)
+  {
+    size_t inflatedSize = 0;
+    const libdeflate_result result = libdeflate_deflate_decompress(decompressor, data, length, &m_buffer[0], m_buffer.size(), &inflatedSize);
+    libdeflate_free_decompressor(decompressor);
+    if ((LIBDEFLATE_SUCCESS == result) && (size >= inflatedSize))
+    {
+      m_buffer.resize(inflatedSize);
+      done = true;
+    }
+    else if (LIBDEFLATE_BAD_DATA == result)
+    {
+      m_failed = true;
+    }
+  }
+#else
+  z_stream strm;
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  strm.avail_in = 0;
+  strm.next_in = Z_NULL;
+  if (Z_OK == inflateInit2(&strm, -MAX_WBITS))
+  {
+    strm.next_in = const_cast<Bytef *>(data);
+    strm.avail_in = uInt(length);
+    strm.next_out = reinterpret_cast<Bytef *>(&m_buffer[0]);
+    strm.avail_out = uInt(m_buffer.size());
+
+    const int ret = inflate(&strm, Z_FINISH);
+    // a truncated stream is accepted, like in fill()
+    if ((Z_STREAM_END == ret) || ((Z_BUF_ERROR == ret) && (0 == strm.avail_in) && (0 < strm.avail_out)))
+    {
+      if (size >= strm.total_out)
+      {
+        m_buffer.resize(strm.total_out);
+        done = true;
+      }
+    }
+    else if (Z_DATA_ERROR == ret)
+    {
+      m_failed = true;
+    }
+    (void) inflateEnd(&strm);
+  }
+#endif
+
+  if (done)
+  {
+    m_finished = true;
+  }
+  else
+  {
+    m_buffer.clear();
+    EBOOK_DEBUG_MSG(("inflating data of expected size %lu failed\n", size));
+  }
+
+  return done;
+}
+
+const unsigned char *EBOOKZlibStream::read(const unsigned long numBytes, unsigned long &numBytesRead) try
+{
+  numBytesRead = 0;
+
+  if (0 == numBytes)
+    return nullptr;
+
+  if (m_pos < m_bufferStart)
+    restart();
+
+  const unsigned long end = (ULONG_MAX - m_pos < numBytes) ? ULONG_MAX : m_pos + numBytes;
+  try
+  {
+    fill(end, m_pos);
+  }
+  catch (const ZlibStreamException &)
+  {
+    // use what has been inflated so far
+  }
+
+  const unsigned long bufferEnd = m_bufferStart + m_buffer.size();
+  if (bufferEnd <= m_pos)
+    return nullptr;
+
+  numBytesRead = std::min(numBytes, bufferEnd - m_pos);
+  const unsigned char *const data = &m_buffer[m_pos - m_bufferStart];
+  m_pos += numBytesRead;
+  return data;
+}
+catch (...)
+{
+  return nullptr;
+}
+
+int EBOOKZlibStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType) try
+{
+  long pos = 0;
+  switch (seekType)
+  {
+  case librevenge::RVNG_SEEK_SET :
+    pos = offset;
+    break;
+  case librevenge::RVNG_SEEK_CUR :
+    pos = offset + static_cast<long>(m_pos);
+    break;
+  case librevenge::RVNG_SEEK_END :
+    if (m_pos < m_bufferStart)
+      restart();
+    try
+    {
+      // keep the data after the current position, so seeking back is cheap
+      fill(ULONG_MAX, m_pos);
+    }
+    catch (const ZlibStreamException &)
+    {
+    }
+    pos = offset + static_cast<long>(m_bufferStart + m_buffer.size());
+    break;
+  default :
+    return -1;
+  }
+
+  if (pos < 0)
+    return 1;
+
+  const auto newPos = static_cast<unsigned long>(pos);
+  if (newPos < m_bufferStart)
+    restart();
+  try
+  {
+    fill(newPos, newPos);
+  }
+  catch (const ZlibStreamException &)
+  {
+  }
+
+  if (newPos > m_bufferStart + m_buffer.size())
+    return 1;
+
+  m_pos = newPos;
+  return 0;
+}
+catch (...)
+{
+  return -1;
+}
+
+bool EBOOKZlibStream::hasFailed() const
+{
+  return m_failed;
 }
 
 long EBOOKZlibStream::tell()
 {
-  return m_stream->tell();
+  return static_cast<long>(m_pos);
+}
+
+bool EBOOKZlibStream::isEnd() try
+{
+  if (m_pos < m_bufferStart)
+    return false;
+
+  try
+  {
+    fill(m_pos + 1, m_pos);
+  }
+  catch (const ZlibStreamException &)
+  {
+  }
+
+  return m_bufferStart + m_buffer.size() == m_pos;
+}
+catch (...)
+{
+  return true;
+}
+
+void EBOOKZlibStream::fill(const unsigned long end, const unsigned long keep)
+{
+  assert(keep >= m_bufferStart);
+
+  while (!m_finished && (m_bufferStart + m_buffer.size() < end))
+  {
+    assert(bool(m_zstream));
+
+    // drop the data that are not needed anymore
+    const unsigned long unneeded = std::min<unsigned long>(keep - m_bufferStart, m_buffer.size());
+    if (OUTPUT_CHUNK_SIZE <= unneeded)
+    {
+      m_buffer.erase(m_buffer.begin(), m_buffer.begin() + long(unneeded));
+      m_bufferStart += unneeded;
+    }
+
+    unsigned long numBytesRead = 0;
+    const unsigned char *input = nullptr;
+    if (0 == m_input->seek(m_inputPos, librevenge::RVNG_SEEK_SET))
+      input = m_input->read(INPUT_CHUNK_SIZE, numBytesRead);
+    if (!input)
+      numBytesRead = 0;
+
+    const std::vector<unsigned char>::size_type size = m_buffer.size();
+    m_buffer.resize(size + OUTPUT_CHUNK_SIZE);
+
+    m_zstream->next_in = const_cast<Bytef *>(input);
+    m_zstream->avail_in = uInt(numBytesRead);
+    m_zstream->next_out = reinterpret_cast<Bytef *>(&m_buffer[size]);
+    m_zstream->avail_out = uInt(OUTPUT_CHUNK_SIZE);
+
+    const int ret = inflate(m_zstream.get(), Z_SYNC_FLUSH);
+
+    m_buffer.resize(m_buffer.size() - m_zstream->avail_out);
+    // the input buffer is only valid until the next read, so unused
+    // input is read again the next time
+    m_inputPos += long(numBytesRead - m_zstream->avail_in);
+    m_zstream->next_in = Z_NULL;
+    m_zstream->avail_in = 0;
+
+    if (Z_STREAM_END == ret)
+    {
+      m_finished = true;
+    }
+    else if ((Z_OK == ret) || (Z_BUF_ERROR == ret))
+    {
+      // a truncated stream ends when there is no more input
+      if ((0 == numBytesRead) && (m_buffer.size() == size))
+        m_finished = true;
+    }
+    else
+    {
+      m_finished = true;
+      m_failed = true;
+      throw ZlibStreamException();
+    }
+  }
 }
 
-bool EBOOKZlibStream::isEnd()
+void EBOOKZlibStream::restart()
 {
-  return m_stream->isEnd();
+  assert(bool(m_zstream));
+
+  if (Z_OK != inflateReset(m_zstream.get()))
+  {
+    m_failed = true;
+    throw ZlibStreamException();
+  }
+  m_inputPos = m_inputBegin;
+  m_buffer.clear();
+  m_bufferStart = 0;
+  m_finished = false;
 }
 
 }
@@ -11,16 +11,44 @@
 #define EBOOKZLIBSTREAM_H_INCLUDED
 
 #include <memory>
+#include <vector>
 
 #include <librevenge-stream/librevenge-stream.h>
 
+struct z_stream_s;
+
 namespace libebook
 {
 
+/** A stream inflating zlib-compressed data.
+  *
+  * The data are inflated on demand, so the input stream must outlive this
+  * stream. Only the data that have not been read yet are kept, so reading
+  * front to back needs little memory. Seeking back before the kept data
+  * inflates the input again from the start.
+  *
+  * A damaged input is only detected at the start; errors found later end
+  * the data, like a truncated input. Use hasFailed() to tell them apart.
+  */
 class EBOOKZlibStream : public librevenge::RVNGInputStream
 {
+  // disable copying
+  EBOOKZlibStream(const EBOOKZlibStream &other);
+  EBOOKZlibStream &operator=(const EBOOKZlibStream &other);
+
 public:
   EBOOKZlibStream(librevenge::RVNGInputStream *stream);
+
+  /** Create a stream for data of known size.
+    *
+    * The data are inflated at once, by libdeflate if it is available.
+    * If the size turns out to be wrong, the data are inflated on demand
+    * as usual. Damaged data are reported by hasFailed() right away.
+    *
+    * @arg[in] stream the compressed input
+    * @arg[in] size the expected size of the inflated data
+    */
+  EBOOKZlibStream(librevenge::RVNGInputStream *stream, unsigned long size);
   ~EBOOKZlibStream() override;
 
   bool isStructured() override;
@@ -35,8 +63,35 @@ public:
   long tell() override;
   bool isEnd() override;
 
+  /** Whether damaged data have been found while inflating.
+    *
+    * @return true if inflating failed, so the data end prematurely
+    */
+  bool hasFailed() const;
+
+private:
+  void open(unsigned long size);
+  bool inflateAll(unsigned long size);
+
+  /** Inflate until the data up to @c end are available.
+    *
+    * @arg[in] end the end of the needed data
+    * @arg[in] keep the start of the data that must not be dropped
+    */
+  void fill(unsigned long end, unsigned long keep);
+
+  void restart();
+
 private:
-  std::unique_ptr<librevenge::RVNGInputStream> m_stream;
+  librevenge::RVNGInputStream *const m_input;
+  std::unique_ptr<z_stream_s> m_zstream; //< inflate state, empty if the data are not compressed
+  long m_inputBegin; //< the start of the deflated data in the input
+  long m_inputPos; //< the first input byte that has not been inflated yet
+  std::vector<unsigned char> m_buffer; //< the inflated data that are kept
+  unsigned long m_bufferStart; //< the position of the first byte of m_buffer
+  unsigned long m_pos;
+  bool m_finished; //< all the data have been inflated
+  bool m_failed; //< inflating failed because of damaged data
 };
 
 }
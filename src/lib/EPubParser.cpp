@@ -201,6 +201,18 @@ void EPubParser::parse()
   }
 }
 
+void EPubParser::parseMetadata()
+{
+  if (m_document)
+  {
+    const RVNGInputStreamPtr_t package(m_input, EBOOKDummyDeleter());
+    const RVNGInputStreamPtr_t opf = getOPFStream(package);
+
+    EBOOKOPFParser parser(opf, package, EBOOKOPFParser::TYPE_EPub, m_document);
+    parser.parseMetadata();
+  }
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -25,6 +25,7 @@ public:
   EPubParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document);
 
   void parse();
+  void parseMetadata();
 
 private:
   librevenge::RVNGInputStream *const m_input;
@@ -39,7 +39,13 @@ class DocumentContext : public FictionBook2ParserContext
   DocumentContext &operator=(const DocumentContext &other);
 
 public:
-  DocumentContext(FictionBook2Collector::NoteMap_t &notes, FictionBook2Collector::BinaryMap_t &bitmaps, librevenge::RVNGTextInterface *document = nullptr);
+  DocumentContext(FictionBook2Collector::NoteMap_t &notes, FictionBook2Collector::BinaryMap_t &bitmaps, librevenge::RVNGTextInterface *document = nullptr, bool metadataOnly = false);
+
+  /** Whether the metadata have been written to the document.
+    *
+    * This is only meaningful if the context was created with metadataOnly.
+    */
+  bool isMetadataWritten() const;
 
 private:
   FictionBook2XMLParserContext *leaveContext() const override;
@@ -56,6 +62,8 @@ private:
   FictionBook2Collector::NoteMap_t &m_notes;
   FictionBook2Collector::BinaryMap_t &m_bitmaps;
   bool m_generating;
+  bool m_metadataOnly;
+  bool m_metadataWritten;
 };
 
 class FictionBookGeneratorContext : public FictionBook2NodeContextBase
@@ -81,6 +89,29 @@ private:
   bool m_bodyRead;
 };
 
+class FictionBookMetadataContext : public FictionBook2NodeContextBase
+{
+  // no copying
+  FictionBookMetadataContext(const FictionBookMetadataContext &other);
+  FictionBookMetadataContext &operator=(const FictionBookMetadataContext &other);
+
+public:
+  FictionBookMetadataContext(FictionBook2ParserContext *parentContext, librevenge::RVNGTextInterface *document, bool &written);
+
+private:
+  FictionBook2XMLParserContext *element(const FictionBook2TokenData &name, const FictionBook2TokenData &ns) override;
+  void endOfElement() override;
+  void attribute(const FictionBook2TokenData &name, const FictionBook2TokenData *ns, const char *value) override;
+
+  void writeMetadata();
+
+private:
+  librevenge::RVNGTextInterface *const m_document;
+  librevenge::RVNGPropertyList m_metadata;
+  FictionBook2MetadataCollector m_metadataCollector;
+  bool &m_written; //< set once the metadata are written; outlives the context
+};
+
 class FictionBookGathererContext : public FictionBook2NodeContextBase
 {
   // no copying
@@ -167,6 +198,56 @@ void FictionBookGeneratorContext::attribute(const FictionBook2TokenData &, const
 {
 }
 
+FictionBookMetadataContext::FictionBookMetadataContext(FictionBook2ParserContext *const parentContext, librevenge::RVNGTextInterface *const document, bool &written)
+  : FictionBook2NodeContextBase(parentContext)
+  , m_document(document)
+  , m_metadata()
+  , m_metadataCollector(m_metadata)
+  , m_written(written)
+{
+}
+
+FictionBook2XMLParserContext *FictionBookMetadataContext::element(const FictionBook2TokenData &name, const FictionBook2TokenData &ns)
+{
+  if (FictionBook2Token::NS_FICTIONBOOK == getFictionBook2TokenID(ns))
+  {
+    switch (getFictionBook2TokenID(name))
+    {
+    case FictionBook2Token::stylesheet :
+      break;
+    case FictionBook2Token::description :
+      return new FictionBook2DescriptionContext(this, &m_metadataCollector);
+    default :
+      // the description is always before the content, so we are done
+      writeMetadata();
+      leaveContext();
+      return nullptr;
+    }
+  }
+
+  return new FictionBook2SkipElementContext(this);
+}
+
+void FictionBookMetadataContext::endOfElement()
+{
+  writeMetadata();
+}
+
+void FictionBookMetadataContext::attribute(const FictionBook2TokenData &, const FictionBook2TokenData *, const char *)
+{
+}
+
+void FictionBookMetadataContext::writeMetadata()
+{
+  if (m_written)
+    return;
+
+  m_document->startDocument(librevenge::RVNGPropertyList());
+  m_document->setDocumentMetaData(m_metadata);
+  m_document->endDocument();
+  m_written = true;
+}
+
 FictionBookGathererContext::FictionBookGathererContext(FictionBook2ParserContext *const parentContext, FictionBook2Collector::NoteMap_t &notes, FictionBook2Collector::BinaryMap_t &bitmaps)
   : FictionBook2NodeContextBase(parentContext)
   , m_notes(notes)
@@ -208,20 +289,29 @@ void FictionBookGathererContext::attribute(const FictionBook2TokenData &, const
 {
 }
 
-DocumentContext::DocumentContext(FictionBook2Collector::NoteMap_t &notes, FictionBook2Collector::BinaryMap_t &bitmaps, librevenge::RVNGTextInterface *const document)
+DocumentContext::DocumentContext(FictionBook2Collector::NoteMap_t &notes, FictionBook2Collector::BinaryMap_t &bitmaps, librevenge::RVNGTextInterface *const document, const bool metadataOnly)
   : FictionBook2ParserContext(nullptr)
   , m_document(document)
   , m_notes(notes)
   , m_bitmaps(bitmaps)
   , m_generating(document != nullptr)
+  , m_metadataOnly(metadataOnly)
+  , m_metadataWritten(false)
+{
+}
+
+bool DocumentContext::isMetadataWritten() const
 {
+  return m_metadataWritten;
 }
 
 FictionBook2XMLParserContext *DocumentContext::element(const FictionBook2TokenData &name, const FictionBook2TokenData &ns)
 {
   if ((FictionBook2Token::NS_FICTIONBOOK == getFictionBook2TokenID(ns)) && (FictionBook2Token::FictionBook == getFictionBook2TokenID(name)))
   {
-    if (m_generating)
+    if (m_generating && m_metadataOnly)
+      return new FictionBookMetadataContext(this, m_document, m_metadataWritten);
+    else if (m_generating)
       return new FictionBookGeneratorContext(this, m_notes, m_bitmaps, m_document);
     else
       return new FictionBookGathererContext(this, m_notes, m_bitmaps);
@@ -395,6 +485,20 @@ bool FictionBook2Parser::parse(librevenge::RVNGTextInterface *const document) co
   return parse(&context);
 }
 
+bool FictionBook2Parser::parseMetadata(librevenge::RVNGTextInterface *const document) const
+{
+  // notes and bitmaps are not needed for metadata, so one pass is enough
+  FictionBook2Collector::NoteMap_t notes;
+  FictionBook2Collector::BinaryMap_t bitmaps;
+
+  DocumentContext context(notes, bitmaps, document, true);
+  parse(&context);
+
+  // the parsing stops early, so the result of parse() is not meaningful;
+  // but the metadata are only written if the FictionBook element was found
+  return context.isMetadataWritten();
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
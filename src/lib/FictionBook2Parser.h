@@ -28,6 +28,12 @@ public:
   bool parse(FictionBook2XMLParserContext *context) const;
   bool parse(librevenge::RVNGTextInterface *document) const;
 
+  /** Parse only the document metadata.
+    *
+    * The parsing stops after the description.
+    */
+  bool parseMetadata(librevenge::RVNGTextInterface *document) const;
+
 private:
   librevenge::RVNGInputStream *const m_input;
 };
@@ -7,6 +7,7 @@
  * For further information visit http://libebook.sourceforge.net
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <map>
@@ -493,6 +494,29 @@ HTMLHelpStream::~HTMLHelpStream()
   delete m_impl->system.data;
 }
 
+bool HTMLHelpStream::isSupported(librevenge::RVNGInputStream *const input)
+{
+  // the signature followed by the two GUIDs checked by libmspack
+  static const unsigned char signature[] = {'I', 'T', 'S', 'F'};
+  static const unsigned char guids[] =
+  {
+    // {7C01FD10-7BAA-11D0-9E0C-00A0C922E6EC}
+    0x10, 0xfd, 0x01, 0x7c, 0xaa, 0x7b, 0xd0, 0x11, 0x9e, 0x0c, 0x00, 0xa0, 0xc9, 0x22, 0xe6, 0xec,
+    // {7C01FD11-7BAA-11D0-9E0C-00A0C922E6EC}
+    0x11, 0xfd, 0x01, 0x7c, 0xaa, 0x7b, 0xd0, 0x11, 0x9e, 0x0c, 0x00, 0xa0, 0xc9, 0x22, 0xe6, 0xec
+  };
+
+  if (!input || (0 != input->seek(0, librevenge::RVNG_SEEK_SET)))
+    return false;
+
+  unsigned long readBytes = 0;
+  const unsigned char *const data = input->read(0x18 + sizeof(guids), readBytes);
+  if (!data || ((0x18 + sizeof(guids)) != readBytes))
+    return false;
+
+  return std::equal(signature, signature + sizeof(signature), data) && std::equal(guids, guids + sizeof(guids), data + 0x18);
+}
+
 bool HTMLHelpStream::isStructured()
 {
   return true;
@@ -29,6 +29,10 @@ public:
   explicit HTMLHelpStream(const RVNGInputStreamPtr_t &input);
   virtual ~HTMLHelpStream();
 
+  /** Check the CHM header without throwing.
+    */
+  static bool isSupported(librevenge::RVNGInputStream *input);
+
   virtual bool isStructured();
   virtual unsigned subStreamCount();
   virtual const char *subStreamName(unsigned id);
@@ -8,6 +8,8 @@
  */
 
 #include <cassert>
+#include <climits>
+#include <cstring>
 #include <vector>
 
 #include "libebook_utils.h"
@@ -22,70 +24,44 @@ namespace libebook
 namespace
 {
 
-void unpack(librevenge::RVNGInputStream *const stream, vector<unsigned char> &buffer)
-{
-  while (!stream->isEnd())
-  {
-    const unsigned char c = readU8(stream);
-
-    if ((c == 0x0) || ((c >= 0x9) && (c <= 0x7f)))
-    {
-      buffer.push_back(c);
-    }
-    else if ((c >= 0x1) && (c <= 0x8))
-    {
-      if (stream->isEnd()) // there is not enough bytes remaining
-        throw GenericException();         // in the current record
-
-      for (unsigned char i = 0; i != c; ++i)
-        buffer.push_back(readU8(stream));
-    }
-    else if ((c >= 0x80) && (c <= 0xbf))
-    {
-      if (stream->isEnd()) // it's not possible to read another byte
-        throw GenericException();    // from the current record
+/// The biggest expansion of the input: a 2 bytes long back-reference
+/// unpacks to up to 10 bytes.
+const unsigned long MAX_UNPACK_RATIO = 5;
 
-      const unsigned byte1 = c & 0x3f; // drop the leftmost 2 bits
-      const unsigned byte2 = readU8(stream);
+/// The size of a single copy of a back-reference.
+const unsigned long COPY_SIZE = 8;
 
-      const unsigned combined = (byte1 << 8) | byte2;
-      // combined contains 14 valid bits. Split them to 11 bits of
-      // distance and 3 bits of length.
-      const unsigned distance = (combined & 0xfff8) >> 3;
-      const unsigned length = (combined & 0x7) + 3;
+template<typename T>
+void unpackInto(const unsigned char *const packed, const unsigned long packedLength, const unsigned long unpackedSize, vector<T> &unpacked)
+{
+  static_assert(sizeof(T) == 1, "the buffer must be byte-sized");
 
-      // TODO: It's probably better idea to just ignore this and
-      // continue reading with the next byte. The worst that can
-      // happen is a missing piece of text.
-      if (distance > buffer.size()) // reading before this record
-        throw GenericException();
-      if (0 == distance)
-        throw GenericException();
+  if (0 == packedLength)
+    throw GenericException();
 
-      if (length <= distance)
-      {
-        for (vector<unsigned char>::size_type i = buffer.size() - distance, last = i + length; i != last; ++i)
-          buffer.push_back(buffer[i]);
-      }
-      else
-      {
-        // Apparently this is sometimes misused to construct sequences
-        // of repeated characters, like ....
-        const char repeated = (char) *(buffer.end() - (int) distance);
-        buffer.insert(buffer.end(), length, (unsigned char) repeated);
-      }
-    }
-    else
-    {
-      buffer.push_back(' ');
-      buffer.push_back(c ^ 0x80);
-    }
+  unsigned long unpackedLength = 0;
+  bool unpackedAll = false;
+  if (0 < unpackedSize)
+  {
+    unpacked.resize(unpackedSize);
+    unpackedAll = PDBLZ77Stream::unpack(packed, packedLength, reinterpret_cast<unsigned char *>(&unpacked[0]), unpacked.size(), unpackedLength);
   }
+  if (!unpackedAll)
+  {
+    // the expected size was wrong or not known
+    unpacked.resize(PDBLZ77Stream::getMaxUnpackedLength(packedLength));
+    unpackedAll = PDBLZ77Stream::unpack(packed, packedLength, reinterpret_cast<unsigned char *>(&unpacked[0]), unpacked.size(), unpackedLength);
+    assert(unpackedAll);
+  }
+
+  if (0 == unpackedLength)
+    throw GenericException();
+  unpacked.resize(unpackedLength);
 }
 
 }
 
-PDBLZ77Stream::PDBLZ77Stream(librevenge::RVNGInputStream *const stream)
+PDBLZ77Stream::PDBLZ77Stream(librevenge::RVNGInputStream *const stream, const unsigned long unpackedSize)
   : m_stream()
 {
   assert(stream);
@@ -93,13 +69,15 @@ PDBLZ77Stream::PDBLZ77Stream(librevenge::RVNGInputStream *const stream)
   if (0 != stream->seek(0, librevenge::RVNG_SEEK_SET))
     throw EndOfStreamException();
 
-  vector<unsigned char> unpacked;
-  unpack(stream, unpacked);
-
-  if (unpacked.empty())
+  const unsigned long packedLength = getRemainingLength(stream);
+  if (0 == packedLength)
     throw GenericException();
+  const unsigned char *const packed = readNBytes(stream, packedLength);
 
-  m_stream.reset(new EBOOKMemoryStream(&unpacked[0], (unsigned) unpacked.size()));
+  vector<unsigned char> unpacked;
+  unpackInto(packed, packedLength, unpackedSize, unpacked);
+
+  m_stream.reset(new EBOOKMemoryStream(std::move(unpacked)));
 }
 
 PDBLZ77Stream::~PDBLZ77Stream()
@@ -156,6 +134,115 @@ bool PDBLZ77Stream::isEnd()
   return m_stream->isEnd();
 }
 
+bool PDBLZ77Stream::unpack(const unsigned char *const input, const unsigned long inputLength,
+                           unsigned char *const output, const unsigned long outputLength,
+                           unsigned long &unpackedLength)
+{
+  const unsigned char *in = input;
+  const unsigned char *const inEnd = input + inputLength;
+  unsigned char *out = output;
+  unsigned char *const outEnd = output + outputLength;
+
+  unpackedLength = 0;
+
+  while (in != inEnd)
+  {
+    const unsigned char c = *in++;
+
+    if ((c == 0x0) || ((c >= 0x9) && (c <= 0x7f)))
+    {
+      if (out == outEnd)
+        return false;
+      *out++ = c;
+    }
+    else if ((c >= 0x1) && (c <= 0x8))
+    {
+      if (in == inEnd) // there is not enough bytes remaining
+        throw GenericException(); // in the current record
+      if (static_cast<unsigned long>(inEnd - in) < c)
+        throw EndOfStreamException();
+      if (static_cast<unsigned long>(outEnd - out) < c)
+        return false;
+
+      std::memcpy(out, in, c);
+      in += c;
+      out += c;
+    }
+    else if ((c >= 0x80) && (c <= 0xbf))
+    {
+      if (in == inEnd) // it's not possible to read another byte
+        throw GenericException(); // from the current record
+
+      const unsigned byte1 = c & 0x3f; // drop the leftmost 2 bits
+      const unsigned byte2 = *in++;
+
+      const unsigned combined = (byte1 << 8) | byte2;
+      // combined contains 14 valid bits. Split them to 11 bits of
+      // distance and 3 bits of length.
+      const unsigned long distance = (combined & 0xfff8) >> 3;
+      const unsigned long length = (combined & 0x7) + 3;
+
+      // TODO: It's probably better idea to just ignore this and
+      // continue reading with the next byte. The worst that can
+      // happen is a missing piece of text.
+      if (distance > static_cast<unsigned long>(out - output)) // reading before this record
+        throw GenericException();
+      if (0 == distance)
+        throw GenericException();
+
+      const unsigned long avail = static_cast<unsigned long>(outEnd - out);
+      if (avail < length)
+        return false;
+
+      const unsigned char *const from = out - distance;
+      if ((COPY_SIZE <= distance) && (2 * COPY_SIZE <= avail))
+      {
+        // The length is at most 10, so two copies are always enough.
+        // The copies cannot overlap and the excess bytes are
+        // overwritten by the following output.
+        std::memcpy(out, from, COPY_SIZE);
+        std::memcpy(out + COPY_SIZE, from + COPY_SIZE, COPY_SIZE);
+      }
+      else if (1 == distance)
+      {
+        // Apparently this is sometimes misused to construct sequences
+        // of repeated characters, like ....
+        std::memset(out, *from, length);
+      }
+      else
+      {
+        // the source and the target may overlap
+        for (unsigned long i = 0; i != length; ++i)
+          out[i] = from[i];
+      }
+      out += length;
+    }
+    else
+    {
+      if (2 > static_cast<unsigned long>(outEnd - out))
+        return false;
+      *out++ = ' ';
+      *out++ = c ^ 0x80;
+    }
+  }
+
+  unpackedLength = static_cast<unsigned long>(out - output);
+  return true;
+}
+
+void PDBLZ77Stream::unpack(const unsigned char *const input, const unsigned long inputLength,
+                           const unsigned long unpackedSize, std::vector<char> &output)
+{
+  unpackInto(input, inputLength, unpackedSize, output);
+}
+
+unsigned long PDBLZ77Stream::getMaxUnpackedLength(const unsigned long inputLength)
+{
+  if (ULONG_MAX / MAX_UNPACK_RATIO < inputLength)
+    return ULONG_MAX;
+  return MAX_UNPACK_RATIO * inputLength;
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -11,6 +11,7 @@
 #define PDBLZ77STREAM_H_INCLUDED
 
 #include <memory>
+#include <vector>
 
 #include <librevenge-stream/librevenge-stream.h>
 
@@ -24,7 +25,14 @@ class PDBLZ77Stream : public librevenge::RVNGInputStream
   PDBLZ77Stream &operator=(const PDBLZ77Stream &other);
 
 public:
-  PDBLZ77Stream(librevenge::RVNGInputStream *stream);
+  /** Create a stream of the unpacked content of @c stream.
+    *
+    * @arg[in] stream the packed data
+    * @arg[in] unpackedSize the expected size of the unpacked data, if
+    *   known. It is only used to size the buffer, so a wrong value does
+    *   not cause an error.
+    */
+  explicit PDBLZ77Stream(librevenge::RVNGInputStream *stream, unsigned long unpackedSize = 0);
   ~PDBLZ77Stream() override;
 
   bool isStructured() override;
@@ -39,6 +47,38 @@ public:
   long tell() override;
   bool isEnd() override;
 
+  /** Unpack PalmDoc LZ77 data into a preallocated buffer.
+    *
+    * @arg[in] input the packed data
+    * @arg[in] inputLength the length of the packed data
+    * @arg[in] output the buffer for the unpacked data
+    * @arg[in] outputLength the capacity of @c output
+    * @arg[out] unpackedLength the length of the unpacked data
+    * @return false if @c output is too small for the unpacked data
+    *
+    * The content of @c output past the unpacked data is unspecified.
+    * @throw GenericException if the packed data are invalid
+    */
+  static bool unpack(const unsigned char *input, unsigned long inputLength,
+                     unsigned char *output, unsigned long outputLength,
+                     unsigned long &unpackedLength);
+
+  /** Unpack PalmDoc LZ77 data into a buffer that is resized as needed.
+    *
+    * @arg[in] input the packed data
+    * @arg[in] inputLength the length of the packed data
+    * @arg[in] unpackedSize the expected size of the unpacked data, if
+    *   known. It is only used to size the buffer.
+    * @arg[out] output the unpacked data
+    * @throw GenericException if the packed data are invalid or empty
+    */
+  static void unpack(const unsigned char *input, unsigned long inputLength,
+                     unsigned long unpackedSize, std::vector<char> &output);
+
+  /** Get the maximal possible size of data unpacked from @c inputLength bytes.
+    */
+  static unsigned long getMaxUnpackedLength(unsigned long inputLength);
+
 private:
   std::unique_ptr<librevenge::RVNGInputStream> m_stream;
 };
@@ -7,14 +7,23 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <list>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "libebook_utils.h"
+#include "EBOOKByteCursor.h"
+#include "EBOOKMemoryStream.h"
 #include "EBOOKStreamView.h"
+#include "EBOOKWorkerThreads.h"
 #include "PDBParser.h"
 
 using std::unique_ptr;
@@ -25,6 +34,9 @@ namespace libebook
 namespace
 {
 
+/// The max. total size of records kept by RecordCache.
+const unsigned long RECORD_CACHE_SIZE = 4 * 1024 * 1024;
+
 struct HeaderData
 {
   HeaderData();
@@ -40,6 +52,61 @@ struct HeaderData
   std::vector<unsigned> m_recordOffsets;
 };
 
+/** A cache of unpacked records of limited size.
+  *
+  * If there is not enough space for a new record, the least recently
+  * used records are dropped. The records are shared, so a dropped record
+  * stays valid while it is in use.
+  */
+class RecordCache
+{
+  // disable copying
+  RecordCache(const RecordCache &other);
+  RecordCache &operator=(const RecordCache &other);
+
+public:
+  typedef std::shared_ptr<const std::vector<char> > Record_t;
+
+public:
+  explicit RecordCache(unsigned long capacity);
+
+  Record_t find(unsigned n);
+  /// Find a record without counting the lookup or changing the order.
+  Record_t peek(unsigned n) const;
+  void insert(unsigned n, const Record_t &record);
+
+  const PDBParser::CacheStatistics &getStatistics() const;
+
+private:
+  typedef std::list<unsigned> Order_t;
+
+  struct Entry
+  {
+    Entry(const Record_t &record, Order_t::iterator position);
+
+    Record_t record;
+    Order_t::iterator position;
+  };
+
+private:
+  const unsigned long m_capacity;
+  unsigned long m_size; //< the total size of the cached records
+  Order_t m_order; //< the cached record numbers, the most recently used first
+  std::unordered_map<unsigned, Entry> m_entries;
+  PDBParser::CacheStatistics m_statistics;
+};
+
+/// A data record unpacked by a worker thread.
+struct UnpackedRecord
+{
+  UnpackedRecord();
+
+  std::vector<unsigned char> packed;
+  std::vector<char> text;
+  std::exception_ptr error;
+  bool done;
+};
+
 }
 
 namespace
@@ -58,15 +125,110 @@ HeaderData::HeaderData()
 {
 }
 
+RecordCache::RecordCache(const unsigned long capacity)
+  : m_capacity(capacity)
+  , m_size(0)
+  , m_order()
+  , m_entries()
+  , m_statistics()
+{
+  m_statistics.hits = 0;
+  m_statistics.misses = 0;
+  m_statistics.evictions = 0;
+}
+
+RecordCache::Entry::Entry(const Record_t &record_, const Order_t::iterator position_)
+  : record(record_)
+  , position(position_)
+{
+}
+
+RecordCache::Record_t RecordCache::find(const unsigned n)
+{
+  const std::unordered_map<unsigned, Entry>::iterator it = m_entries.find(n);
+  if (m_entries.end() == it)
+  {
+    ++m_statistics.misses;
+    return Record_t();
+  }
+
+  ++m_statistics.hits;
+  m_order.splice(m_order.begin(), m_order, it->second.position);
+  return it->second.record;
+}
+
+RecordCache::Record_t RecordCache::peek(const unsigned n) const
+{
+  const std::unordered_map<unsigned, Entry>::const_iterator it = m_entries.find(n);
+  if (m_entries.end() == it)
+    return Record_t();
+  return it->second.record;
+}
+
+void RecordCache::insert(const unsigned n, const Record_t &record)
+{
+  assert(m_entries.end() == m_entries.find(n));
+
+  if (record->size() > m_capacity)
+    return;
+
+  while (m_size + record->size() > m_capacity)
+  {
+    const std::unordered_map<unsigned, Entry>::iterator it = m_entries.find(m_order.back());
+    assert(m_entries.end() != it);
+    m_size -= it->second.record->size();
+    m_entries.erase(it);
+    m_order.pop_back();
+    ++m_statistics.evictions;
+  }
+
+  m_order.push_front(n);
+  m_entries.insert(std::make_pair(n, Entry(record, m_order.begin())));
+  m_size += record->size();
+}
+
+const PDBParser::CacheStatistics &RecordCache::getStatistics() const
+{
+  return m_statistics;
+}
+
+UnpackedRecord::UnpackedRecord()
+  : packed()
+  , text()
+  , error()
+  , done(false)
+{
+}
+
+void readAll(librevenge::RVNGInputStream *const input, std::vector<unsigned char> &data)
+{
+  data.clear();
+  if (!input)
+    return;
+
+  const unsigned long length = getRemainingLength(input);
+  if (0 != length)
+  {
+    const unsigned char *const bytes = readNBytes(input, length);
+    data.assign(bytes, bytes + length);
+  }
+}
+
 }
 
 struct PDBParserImpl
 {
   PDBParserImpl(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document);
 
+  librevenge::RVNGInputStream *createStream(unsigned long begin, unsigned long end) const;
+
   HeaderData m_header;
   librevenge::RVNGInputStream *m_input;
   librevenge::RVNGTextInterface *m_document;
+  unsigned long m_fileSize;
+  const unsigned char *m_content; //< the whole input, if it stays in memory
+  RecordCache m_recordCache;
+  unsigned m_threadCount;
 
 private:
 // disable copying
@@ -78,9 +240,23 @@ PDBParserImpl::PDBParserImpl(librevenge::RVNGInputStream *const input, libreveng
   : m_header()
   , m_input(input)
   , m_document(document)
+  , m_fileSize(0)
+  , m_content(nullptr)
+  , m_recordCache(RECORD_CACHE_SIZE)
+  , m_threadCount(1)
 {
 }
 
+librevenge::RVNGInputStream *PDBParserImpl::createStream(const unsigned long begin, const unsigned long end) const
+{
+  if ((begin > end) || (end > m_fileSize))
+    throw EndOfStreamException();
+
+  if (m_content)
+    return new EBOOKMemoryStream(m_content + begin, unsigned(end - begin), EBOOKMemoryStream::DATA_OWNERSHIP_BORROW);
+  return new EBOOKStreamView(m_input, long(begin), long(end), EBOOKStreamView::BOUNDS_TRUSTED);
+}
+
 PDBParser::PDBParser(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document,
                      const unsigned type, const unsigned creator)
   : m_impl(new PDBParserImpl(input, document))
@@ -99,6 +275,37 @@ PDBParser::~PDBParser()
 {
 }
 
+bool PDBParser::isSupported(librevenge::RVNGInputStream *const input)
+{
+  if (!input || (0 != input->seek(0, librevenge::RVNG_SEEK_END)))
+    return false;
+  const long fileSize = input->tell();
+  if ((fileSize < 78) || (0 != input->seek(76, librevenge::RVNG_SEEK_SET)))
+    return false;
+
+  unsigned long readBytes = 0;
+  const unsigned char *data = input->read(2, readBytes);
+  if (!data || (2 != readBytes))
+    return false;
+  const unsigned numberOfRecords = std::min<unsigned>(unsigned(data[0] << 8) | data[1], (fileSize - 78) / 8);
+  if (0 == numberOfRecords)
+    return false;
+
+  // the records must start after the record list and lie inside the file
+  const unsigned long listEnd = 78 + 8 * numberOfRecords;
+  data = input->read(8 * numberOfRecords, readBytes);
+  if (!data || (8 * numberOfRecords != readBytes))
+    return false;
+  for (unsigned i = 0; numberOfRecords != i; ++i)
+  {
+    const unsigned long offset = EBOOKBigEndian::getU32(data + 8 * i);
+    if ((offset < listEnd) || (offset > (unsigned long) fileSize))
+      return false;
+  }
+
+  return true;
+}
+
 bool PDBParser::parse()
 {
   if (m_impl->m_header.m_appInfoID)
@@ -120,6 +327,33 @@ bool PDBParser::parse()
   return true;
 }
 
+bool PDBParser::parseMetadata()
+{
+  {
+    std::unique_ptr<librevenge::RVNGInputStream> input(getRecordStream(0));
+    readIndexRecord(input.get());
+  }
+
+  readMetadata();
+
+  return true;
+}
+
+void PDBParser::setDocument(librevenge::RVNGTextInterface *const document)
+{
+  m_impl->m_document = document;
+}
+
+void PDBParser::setThreadCount(const unsigned count)
+{
+  m_impl->m_threadCount = (0 == count) ? 1 : count;
+}
+
+PDBParser::CacheStatistics PDBParser::getCacheStatistics() const
+{
+  return m_impl->m_recordCache.getStatistics();
+}
+
 librevenge::RVNGTextInterface *PDBParser::getDocument() const
 {
   return m_impl->m_document;
@@ -151,13 +385,34 @@ librevenge::RVNGInputStream *PDBParser::getDataRecord(unsigned n) const
   return getRecordStream(n + 1);
 }
 
-librevenge::RVNGInputStream *PDBParser::getDataRecords() const
+librevenge::RVNGInputStream *PDBParser::getUnpackedDataRecord(const unsigned n, const CachePolicy policy) const
 {
-  const auto begin = (long) m_impl->m_header.m_recordOffsets[1];
-  m_impl->m_input->seek(0, librevenge::RVNG_SEEK_END);
-  const long end = m_impl->m_input->tell();
+  if (getDataRecordCount() <= n)
+    return nullptr;
 
-  return new EBOOKStreamView(m_impl->m_input, begin, end);
+  RecordCache::Record_t record = m_impl->m_recordCache.find(n);
+  if (!record)
+  {
+    const unique_ptr<librevenge::RVNGInputStream> input(getDataRecord(n));
+    std::vector<unsigned char> data;
+    readAll(input.get(), data);
+
+    const std::shared_ptr<std::vector<char> > unpacked(new std::vector<char>());
+    unpackDataRecord(data.empty() ? nullptr : &data[0], data.size(), *unpacked);
+    record = unpacked;
+    if (CACHE_POLICY_KEEP == policy)
+      m_impl->m_recordCache.insert(n, record);
+  }
+
+  if (record->empty())
+    return new EBOOKMemoryStream();
+  const std::shared_ptr<const unsigned char> bytes(record, reinterpret_cast<const unsigned char *>(&(*record)[0]));
+  return new EBOOKMemoryStream(bytes, unsigned(record->size()));
+}
+
+librevenge::RVNGInputStream *PDBParser::getDataRecords() const
+{
+  return m_impl->createStream(m_impl->m_header.m_recordOffsets[1], m_impl->m_fileSize);
 }
 
 librevenge::RVNGInputStream *PDBParser::getDataRecords(unsigned first, unsigned last) const
@@ -167,21 +422,67 @@ librevenge::RVNGInputStream *PDBParser::getDataRecords(unsigned first, unsigned
   if ((m_impl->m_header.m_numberOfRecords - 1) < last)
     return nullptr;
 
-  const auto begin = (long) m_impl->m_header.m_recordOffsets[first + 1];
-  long end = 0;
-  if ((m_impl->m_header.m_numberOfRecords - 1) == last) // ends with the last record
-  {
-    m_impl->m_input->seek(0, librevenge::RVNG_SEEK_END);
-    end = m_impl->m_input->tell();
-  }
-  else
-    end = (long) m_impl->m_header.m_recordOffsets[last + 1];
+  const unsigned long begin = m_impl->m_header.m_recordOffsets[first + 1];
+  unsigned long end = m_impl->m_fileSize;
+  if ((m_impl->m_header.m_numberOfRecords - 1) != last) // does not end with the last record
+    end = m_impl->m_header.m_recordOffsets[last + 1];
+
+  return m_impl->createStream(begin, end);
+}
+
+bool PDBParser::canUnpackDataRecords() const
+{
+  return false;
+}
+
+void PDBParser::unpackDataRecord(const unsigned char *const data, const unsigned long length, std::vector<char> &text) const
+{
+  text.assign(data, data + length);
+}
 
-  return new EBOOKStreamView(m_impl->m_input, begin, end);
+void PDBParser::readUnpackedDataRecord(const std::vector<char> &text, const bool last)
+{
+  EBOOKMemoryStream record(reinterpret_cast<const unsigned char *>(text.empty() ? nullptr : &text[0]), unsigned(text.size()),
+                           EBOOKMemoryStream::DATA_OWNERSHIP_BORROW);
+  readDataRecord(&record, last);
 }
 
 void PDBParser::readDataRecords()
 {
+  const unsigned threadCount = std::min(m_impl->m_threadCount, getDataRecordCount());
+  if ((1 < threadCount) && canUnpackDataRecords())
+  {
+    readDataRecordsInParallel(threadCount);
+    return;
+  }
+
+  if (canUnpackDataRecords())
+  {
+    // Records are only read once here, so they are not added to the
+    // cache; but a record unpacked before, e.g., by readMetadata(), is
+    // taken from it. The lookup is not counted in the statistics, which
+    // only describe requests by getUnpackedDataRecord().
+    const unsigned count = getDataRecordCount();
+    std::vector<unsigned char> data;
+    std::vector<char> text;
+    for (unsigned i = 0; i != count; ++i)
+    {
+      const RecordCache::Record_t cached = m_impl->m_recordCache.peek(i);
+      if (cached)
+      {
+        readUnpackedDataRecord(*cached, count == i + 1);
+      }
+      else
+      {
+        const unique_ptr<librevenge::RVNGInputStream> record(getDataRecord(i));
+        readAll(record.get(), data);
+        unpackDataRecord(data.empty() ? nullptr : &data[0], data.size(), text);
+        readUnpackedDataRecord(text, count == i + 1);
+      }
+    }
+    return;
+  }
+
   for (unsigned i = 1; i != m_impl->m_header.m_numberOfRecords; ++i)
   {
     unique_ptr<librevenge::RVNGInputStream> record(getRecordStream(i));
@@ -189,9 +490,101 @@ void PDBParser::readDataRecords()
   }
 }
 
+void PDBParser::readDataRecordsInParallel(const unsigned threadCount)
+{
+  // Records are read from the input in order and unpacked by worker
+  // threads. The buffers for them are reused, so the workers can only
+  // get as many records ahead of the record being read as there are
+  // buffers.
+  const unsigned count = getDataRecordCount();
+  std::vector<UnpackedRecord> records(2 * threadCount);
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  unsigned queued = 0;
+  unsigned next = 0;
+  bool stopped = false;
+
+  const auto unpack = [&]()
+  {
+    while (true)
+    {
+      unsigned current = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]()
+        {
+          return stopped || (queued != next);
+        });
+        if (stopped)
+          return;
+        current = next++;
+      }
+
+      UnpackedRecord &record = records[current % records.size()];
+      try
+      {
+        unpackDataRecord(record.packed.empty() ? nullptr : &record.packed[0], record.packed.size(), record.text);
+      }
+      catch (...)
+      {
+        record.error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        record.done = true;
+      }
+      changed.notify_all();
+    }
+  };
+
+  EBOOKWorkerThreads workers(mutex, changed, stopped);
+  for (unsigned i = 0; threadCount != i; ++i)
+    workers.start(unpack);
+
+  for (unsigned i = 0; count != i; ++i)
+  {
+    // queue records into the free buffers
+    while ((count != queued) && (i + records.size() != queued))
+    {
+      UnpackedRecord &record = records[queued % records.size()];
+      const unique_ptr<librevenge::RVNGInputStream> input(getDataRecord(queued));
+      readAll(input.get(), record.packed);
+      record.error = std::exception_ptr();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        record.done = false;
+        ++queued;
+      }
+      changed.notify_all();
+    }
+
+    UnpackedRecord &record = records[i % records.size()];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&]()
+      {
+        return record.done;
+      });
+    }
+
+    if (record.error)
+      std::rethrow_exception(record.error);
+    readUnpackedDataRecord(record.text, count == i + 1);
+  }
+}
+
+void PDBParser::readMetadata()
+{
+  readDataRecords();
+}
+
 void PDBParser::readHeader()
 {
   m_impl->m_input->seek(0, librevenge::RVNG_SEEK_SET);
+  m_impl->m_fileSize = getRemainingLength(m_impl->m_input);
 
   char name[32];
   unsigned nameLen = 0;
@@ -220,14 +613,29 @@ void PDBParser::readHeader()
   m_impl->m_header.m_nextRecordListID = readU32(m_impl->m_input, true);
   assert(m_impl->m_input->tell() == 76);
   m_impl->m_header.m_numberOfRecords = readU16(m_impl->m_input, true);
-  if (m_impl->m_header.m_numberOfRecords > getRemainingLength(m_impl->m_input) / 8)
-    m_impl->m_header.m_numberOfRecords = getRemainingLength(m_impl->m_input) / 8;
+  const unsigned long remaining = m_impl->m_fileSize - 78;
+  if (m_impl->m_header.m_numberOfRecords > remaining / 8)
+    m_impl->m_header.m_numberOfRecords = unsigned(remaining / 8);
 
   // read records
-  for (unsigned i = 0; i != m_impl->m_header.m_numberOfRecords; ++i)
+  if (0 != m_impl->m_header.m_numberOfRecords)
   {
-    m_impl->m_header.m_recordOffsets.push_back(readU32(m_impl->m_input, true));
-    skip(m_impl->m_input, 4); // skip the uninteresting remainder
+    const unsigned long listLength = 8 * m_impl->m_header.m_numberOfRecords;
+    EBOOKByteCursor list(readNBytes(m_impl->m_input, listLength), listLength);
+    m_impl->m_header.m_recordOffsets.reserve(m_impl->m_header.m_numberOfRecords);
+    for (unsigned i = 0; i != m_impl->m_header.m_numberOfRecords; ++i)
+    {
+      m_impl->m_header.m_recordOffsets.push_back(list.readU32<EBOOKBigEndian>());
+      list.skip(4); // skip the uninteresting remainder
+    }
+  }
+
+  // Records are read often, so keep the content if it is in memory
+  // anyway, to give out records without going through the stream.
+  if (isInMemory(m_impl->m_input))
+  {
+    m_impl->m_input->seek(0, librevenge::RVNG_SEEK_SET);
+    m_impl->m_content = readNBytes(m_impl->m_input, m_impl->m_fileSize);
   }
 }
 
@@ -236,17 +644,12 @@ librevenge::RVNGInputStream *PDBParser::getRecordStream(const unsigned n) const
   if (n >= m_impl->m_header.m_numberOfRecords)
     return nullptr;
 
-  const auto begin = (long) m_impl->m_header.m_recordOffsets[n];
-  long end = 0;
-  if ((m_impl->m_header.m_numberOfRecords - 1) == n) // the last record
-  {
-    m_impl->m_input->seek(0, librevenge::RVNG_SEEK_END);
-    end = m_impl->m_input->tell();
-  }
-  else
-    end = (long) m_impl->m_header.m_recordOffsets[n + 1];
+  const unsigned long begin = m_impl->m_header.m_recordOffsets[n];
+  unsigned long end = m_impl->m_fileSize;
+  if ((m_impl->m_header.m_numberOfRecords - 1) != n) // not the last record
+    end = m_impl->m_header.m_recordOffsets[n + 1];
 
-  return new EBOOKStreamView(m_impl->m_input, begin, end);
+  return m_impl->createStream(begin, end);
 }
 
 }
@@ -11,6 +11,7 @@
 #define PDBPARSER_H_INCLUDED
 
 #include <memory>
+#include <vector>
 
 #include <librevenge/librevenge.h>
 #include <librevenge-stream/librevenge-stream.h>
@@ -28,15 +29,72 @@ class PDBParser
   PDBParser(const PDBParser &other);
   PDBParser &operator=(const PDBParser &other);
 
+public:
+  /** Statistics of the cache of unpacked data records.
+    */
+  struct CacheStatistics
+  {
+    unsigned long hits; //< the number of records found in the cache
+    unsigned long misses; //< the number of records that had to be unpacked
+    unsigned long evictions; //< the number of records dropped to make space for others
+  };
+
 public:
   virtual ~PDBParser() = 0;
 
+  /** Check that the input looks like a valid Palm database.
+    *
+    * The header and the record list are checked for sanity. This
+    * never throws, so it is suitable for cheap format detection.
+    *
+    * @arg[in] input input stream
+    * @return true if the header and the record list are sane
+    */
+  static bool isSupported(librevenge::RVNGInputStream *input);
+
   /** Parse input and produce output to @e document.
     *
     * @return true if the input has been parsed successfully.
     */
   bool parse();
 
+  /** Parse only the document metadata and produce them to @e document.
+    *
+    * Subformats that can find the metadata without reading the text
+    * stop early; the others read the whole document.
+    *
+    * @return true if the input has been parsed successfully.
+    */
+  bool parseMetadata();
+
+  /** Set the document generator used for parsing.
+    *
+    * This allows to reuse a parser created during format detection,
+    * without reading the header and the record list again.
+    *
+    * @arg[in] document output document generator
+    */
+  void setDocument(librevenge::RVNGTextInterface *document);
+
+  /** Set the max. number of threads used to unpack data records.
+    *
+    * @arg[in] count the number of threads; 0 is treated as 1
+    */
+  void setThreadCount(unsigned count);
+
+  /** Get statistics of the cache used by getUnpackedDataRecord().
+    */
+  CacheStatistics getCacheStatistics() const;
+
+protected:
+  /** Whether getUnpackedDataRecord() keeps the unpacked record.
+    */
+  enum CachePolicy
+  {
+    CACHE_POLICY_KEEP, //< the record is kept in the cache for later requests
+    CACHE_POLICY_DROP //< the record is only read once, so it is not cached
+  };
+
 protected:
   /** Instantiate a parser for a document in Palm Database Format.
     *
@@ -88,6 +146,22 @@ protected:
     */
   librevenge::RVNGInputStream *getDataRecord(unsigned n) const;
 
+  /** Return a stream for the unpacked content of the n-th data record.
+    *
+    * The record is unpacked by unpackDataRecord(). Recently used
+    * records are kept in a cache of limited size, so a record that is
+    * requested repeatedly is only unpacked once. A record that is only
+    * going to be read once should be requested with
+    * CACHE_POLICY_DROP, so it does not push useful records out of the
+    * cache.
+    *
+    * @arg[in] n the record number, 0-based
+    * @arg[in] policy whether the unpacked record is added to the cache
+    * @return a newly allocated stream spanning the unpacked record or
+    *         0, if there is no such record
+    */
+  librevenge::RVNGInputStream *getUnpackedDataRecord(unsigned n, CachePolicy policy = CACHE_POLICY_KEEP) const;
+
   /** Return a stream for all data records.
     *
     * @return a newly allocated stream spanning all data records
@@ -109,8 +183,51 @@ private:
   virtual void readIndexRecord(librevenge::RVNGInputStream *record) = 0;
   virtual void readDataRecord(librevenge::RVNGInputStream *record, bool last = false) = 0;
 
+  /** Check if data records can be unpacked independently of each other.
+    *
+    * If they can, records may be unpacked by unpackDataRecord() in
+    * worker threads and then passed to readUnpackedDataRecord() in the
+    * original order, instead of being read by readDataRecord(). This is
+    * only done if more than one thread is allowed by
+    * setThreadCount().
+    *
+    * The default implementation returns false.
+    */
+  virtual bool canUnpackDataRecords() const;
+
+  /** Unpack a data record.
+    *
+    * This is used by getUnpackedDataRecord() and it is called from
+    * worker threads if canUnpackDataRecords() returns true, so it must
+    * not change the state of the parser. getUnpackedDataRecord() calls
+    * it regardless of canUnpackDataRecords(), so it must also handle
+    * records that are not packed.
+    *
+    * The default implementation returns the record as it is.
+    *
+    * @arg[in] data the content of the record
+    * @arg[in] length the length of the record
+    * @arg[out] text the unpacked record
+    */
+  virtual void unpackDataRecord(const unsigned char *data, unsigned long length, std::vector<char> &text) const;
+
+  /** Read a data record unpacked by unpackDataRecord().
+    *
+    * @arg[in] text the unpacked record
+    * @arg[in] last true if this is the last data record
+    */
+  virtual void readUnpackedDataRecord(const std::vector<char> &text, bool last);
+
   virtual void readDataRecords();
 
+  void readDataRecordsInParallel(unsigned threadCount);
+
+  /** Read the document metadata.
+    *
+    * The default implementation reads all data records.
+    */
+  virtual void readMetadata();
+
   void readHeader();
 
   librevenge::RVNGInputStream *getRecordStream(unsigned n) const;
@@ -7,7 +7,6 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
-#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -22,6 +21,20 @@ using std::vector;
 namespace libebook
 {
 
+namespace
+{
+
+/// Read the rest of the stream, without copying it.
+const char *readAll(librevenge::RVNGInputStream *const input, unsigned long &length)
+{
+  length = getRemainingLength(input);
+  if (0 == length)
+    return nullptr;
+  return reinterpret_cast<const char *>(readNBytes(input, length));
+}
+
+}
+
 //static const unsigned PALMDOC_BLOCK_SIZE = 4096;
 
 static const unsigned PALMDOC_TYPE = PDB_CODE("TEXt");
@@ -37,6 +50,7 @@ PalmDocParser::PalmDocParser(librevenge::RVNGInputStream *input, librevenge::RVN
   , m_openedParagraph(false)
   , m_openedDocument(false)
   , m_converter()
+  , m_convertedText()
 {
 }
 
@@ -79,66 +93,104 @@ void PalmDocParser::readIndexRecord(librevenge::RVNGInputStream *const input)
 
 void PalmDocParser::readDataRecord(librevenge::RVNGInputStream *input, const bool last)
 {
-  vector<char> uncompressed;
-  uncompressed.reserve(m_recordSize);
-
   std::unique_ptr<librevenge::RVNGInputStream> compressedInput;
 
   if (m_compressed)
   {
-    compressedInput.reset(new PDBLZ77Stream(input));
+    compressedInput.reset(new PDBLZ77Stream(input, m_recordSize));
     input = compressedInput.get();
   }
 
-  const long origPos = input->tell();
-  while (!input->isEnd())
-    uncompressed.push_back((char) readU8(input));
-  m_read += unsigned(input->tell() - origPos);
+  unsigned long length = 0;
+  const char *const text = readAll(input, length);
+  handleRecord(text, length, last);
+}
+
+bool PalmDocParser::canUnpackDataRecords() const
+{
+  // uncompressed records are used as they are
+  return m_compressed;
+}
+
+void PalmDocParser::unpackDataRecord(const unsigned char *const data, const unsigned long length, vector<char> &text) const
+{
+  // getUnpackedDataRecord() calls this for uncompressed records too
+  if (m_compressed)
+    PDBLZ77Stream::unpack(data, length, m_recordSize, text);
+  else
+    text.assign(data, data + length);
+}
+
+void PalmDocParser::readUnpackedDataRecord(const vector<char> &uncompressed, const bool last)
+{
+  handleRecord(uncompressed.empty() ? nullptr : &uncompressed[0], uncompressed.size(), last);
+}
+
+void PalmDocParser::readMetadata()
+{
+  // The encoding of the name is guessed from the text, so the first
+  // record must be read. The rest can be skipped.
+  // The record is kept in the cache, so a full parse afterwards does
+  // not have to unpack it again.
+  const std::unique_ptr<librevenge::RVNGInputStream> record(getUnpackedDataRecord(0));
+  unsigned long length = 0;
+  const char *text = bool(record) ? readAll(record.get(), length) : nullptr;
+  if (0 == length)
+  {
+    text = getName();
+    length = std::strlen(getName());
+  }
+  createConverter(text, length);
+
+  getDocument()->startDocument(librevenge::RVNGPropertyList());
+  getDocument()->setDocumentMetaData(getMetadata());
+  getDocument()->endDocument();
+}
+
+void PalmDocParser::handleRecord(const char *const text, const unsigned long length, const bool last)
+{
+  m_read += unsigned(length);
 
   // assert(m_read <= m_textLength);
   // if (last)
   // assert(m_read == m_textLength);
 
-  if (!m_openedDocument && !uncompressed.empty())
+  if (!m_openedDocument && (0 != length))
   {
-    createConverter(uncompressed);
+    createConverter(text, length);
     openDocument();
   }
 
-  handleText(uncompressed);
+  handleText(text, length);
 
   if (last)
   {
     if (!m_openedDocument)
     {
-      std::vector<char> name(getName(), getName() + std::strlen(getName()));
-      createConverter(name);
+      createConverter(getName(), std::strlen(getName()));
       openDocument();
     }
     closeDocument();
   }
 }
 
-void PalmDocParser::createConverter(const std::vector<char> &text)
+void PalmDocParser::createConverter(const char *const text, const unsigned long length)
 {
-  if (text.empty())
+  if (0 == length)
     return;
 
   std::unique_ptr<EBOOKCharsetConverter> converter(new EBOOKCharsetConverter());
-  if (converter->guessEncoding(&text[0], (unsigned) text.size()))
+  if (converter->guessEncoding(text, (unsigned) length))
     m_converter = std::move(converter);
   else
     throw GenericException();
 }
 
-void PalmDocParser::openDocument()
+librevenge::RVNGPropertyList PalmDocParser::getMetadata() const
 {
-  if (m_openedDocument)
-    return;
-
   librevenge::RVNGPropertyList metadata;
 
-  if (*getName())
+  if (*getName() && m_converter)
   {
     vector<char> nameUtf8;
     if (m_converter->convertBytes(getName(), (unsigned int)std::strlen(getName()), nameUtf8) && !nameUtf8.empty())
@@ -148,8 +200,16 @@ void PalmDocParser::openDocument()
     }
   }
 
+  return metadata;
+}
+
+void PalmDocParser::openDocument()
+{
+  if (m_openedDocument)
+    return;
+
   getDocument()->startDocument(librevenge::RVNGPropertyList());
-  getDocument()->setDocumentMetaData(metadata);
+  getDocument()->setDocumentMetaData(getMetadata());
   getDocument()->openPageSpan(getDefaultPageSpanPropList());
 
   m_openedDocument = true;
@@ -167,31 +227,72 @@ void PalmDocParser::closeDocument()
   m_openedDocument = false;
 }
 
-void PalmDocParser::handleText(const vector<char> &text)
+void PalmDocParser::handleText(const char *const text, const unsigned long length)
+{
+  if (0 == length)
+    return;
+
+  // The whole record is converted at once. The paragraphs are then
+  // terminated in place, so the converted text must be in our buffer,
+  // even if it did not need any conversion.
+  unsigned convertedLength = 0;
+  const char *const converted = m_converter->convertBytes(text, unsigned(length), m_convertedText, convertedLength);
+  if (!converted)
+  {
+    EBOOK_DEBUG_MSG(("could not convert text, converting paragraphs separately\n"));
+    handleParagraphs(text, length);
+    return;
+  }
+  if (converted != m_convertedText.data())
+    m_convertedText.assign(converted, converted + convertedLength);
+  else
+    m_convertedText.resize(convertedLength);
+  m_convertedText.push_back(0);
+
+  char *first = &m_convertedText[0];
+  char *const end = first + convertedLength;
+
+  while (first != end)
+  {
+    char *const last = static_cast<char *>(std::memchr(first, '\n', static_cast<size_t>(end - first)));
+    char *const paragraphEnd = last ? last : end;
+
+    openParagraph();
+    if (paragraphEnd != first)
+    {
+      *paragraphEnd = 0;
+      handleCharacters(first);
+    }
+    closeParagraph(!last);
+
+    first = last ? last + 1 : end;
+  }
+}
+
+void PalmDocParser::handleParagraphs(const char *const text, const unsigned long length)
 {
-  auto first(text.begin());
-  auto last(text.begin());
-  const vector<char>::const_iterator end(text.end());
+  // Only the text of the paragraphs that cannot be converted is lost.
+  const char *first = text;
+  const char *const end = text + length;
 
   while (first != end)
   {
-    last = std::find(first, end, '\n');
+    const char *const last = static_cast<const char *>(std::memchr(first, '\n', static_cast<size_t>(end - first)));
+    const char *const paragraphEnd = last ? last : end;
 
     openParagraph();
-    if (last > first)
+    if (paragraphEnd != first)
     {
-      vector<char> out;
-      if (m_converter->convertBytes(&*first, static_cast<unsigned>(last - first), out) && !out.empty())
+      vector<char> &out = m_convertedText;
+      if (m_converter->convertBytes(first, static_cast<unsigned>(paragraphEnd - first), out) && !out.empty())
       {
         out.push_back(0);
         handleCharacters(&out[0]);
       }
     }
-    closeParagraph(last == end);
+    closeParagraph(!last);
 
-    first = last;
-    if (first != end)
-      ++first;
+    first = last ? last + 1 : end;
   }
 }
 
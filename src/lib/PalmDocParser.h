@@ -40,12 +40,19 @@ private:
   void readSortInfoRecord(librevenge::RVNGInputStream *record) override;
   void readIndexRecord(librevenge::RVNGInputStream *record) override;
   void readDataRecord(librevenge::RVNGInputStream *record, bool last) override;
+  bool canUnpackDataRecords() const override;
+  void unpackDataRecord(const unsigned char *data, unsigned long length, std::vector<char> &text) const override;
+  void readUnpackedDataRecord(const std::vector<char> &text, bool last) override;
+  void readMetadata() override;
 
-  void createConverter(const std::vector<char> &text);
+  void handleRecord(const char *text, unsigned long length, bool last);
+  void createConverter(const char *text, unsigned long length);
 
+  librevenge::RVNGPropertyList getMetadata() const;
   void openDocument();
   void closeDocument();
-  void handleText(const std::vector<char> &text);
+  void handleText(const char *text, unsigned long length);
+  void handleParagraphs(const char *text, unsigned long length);
   void openParagraph();
   void closeParagraph(bool continuing = false);
   void handleCharacters(const char *text);
@@ -70,6 +77,7 @@ private:
   bool m_openedDocument;
 
   std::unique_ptr<EBOOKCharsetConverter> m_converter;
+  std::vector<char> m_convertedText; //< reused buffer for the converted text of a record
 };
 
 }
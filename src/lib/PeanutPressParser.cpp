@@ -15,7 +15,6 @@
 
 #include "libebook_utils.h"
 #include "EBOOKCharsetConverter.h"
-#include "EBOOKMemoryStream.h"
 #include "EBOOKUTF8Stream.h"
 #include "EBOOKZlibStream.h"
 #include "PDBLZ77Stream.h"
@@ -49,31 +48,6 @@ enum Compression
 
 Compression readCompression(librevenge::RVNGInputStream *indexStream);
 
-class XorStream : public librevenge::RVNGInputStream
-{
-  class StreamException
-  {
-  };
-
-public:
-  XorStream(librevenge::RVNGInputStream *stream, unsigned char xorValue);
-
-  bool isStructured() override;
-  unsigned subStreamCount() override;
-  const char *subStreamName(unsigned id) override;
-  bool existsSubStream(const char *name) override;
-  librevenge::RVNGInputStream *getSubStreamByName(const char *name) override;
-  RVNGInputStream *getSubStreamById(unsigned id) override;
-
-  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
-  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
-  long tell() override;
-  bool isEnd() override;
-
-private:
-  std::unique_ptr<librevenge::RVNGInputStream> m_stream;
-};
-
 }
 
 namespace
@@ -100,82 +74,6 @@ Compression readCompression(librevenge::RVNGInputStream *strm)
   return PEANUTPRESS_COMPRESSION_UNKNOWN;
 }
 
-XorStream::XorStream(librevenge::RVNGInputStream *strm, unsigned char xorValue)
-  : m_stream()
-{
-  assert(strm);
-
-  if (0 != strm->seek(0, librevenge::RVNG_SEEK_END))
-    throw StreamException();
-  const long end = strm->tell();
-  if (0 != strm->seek(0, librevenge::RVNG_SEEK_SET))
-    throw StreamException();
-  if (0 >= end)
-    throw StreamException();
-
-  unsigned long numBytesRead = 0;
-  const unsigned char *bytes = strm->read((unsigned long) end, numBytesRead);
-  if (static_cast<unsigned long>(end) != numBytesRead)
-    throw StreamException();
-
-  vector<unsigned char> data;
-  data.reserve(numBytesRead);
-  for (unsigned long i = 0; i != numBytesRead; ++i)
-    data.push_back(bytes[i] ^ xorValue);
-
-  m_stream.reset(new EBOOKMemoryStream(&data[0], (unsigned) data.size()));
-}
-
-bool XorStream::isStructured()
-{
-  return m_stream->isStructured();
-}
-
-unsigned XorStream::subStreamCount()
-{
-  return 0;
-}
-
-const char *XorStream::subStreamName(unsigned)
-{
-  return nullptr;
-}
-
-bool XorStream::existsSubStream(const char *const name)
-{
-  return m_stream->existsSubStream(name);
-}
-
-librevenge::RVNGInputStream *XorStream::getSubStreamByName(const char *name)
-{
-  return m_stream->getSubStreamByName(name);
-}
-
-librevenge::RVNGInputStream *XorStream::getSubStreamById(unsigned)
-{
-  return nullptr;
-}
-
-const unsigned char *XorStream::read(unsigned long numBytes, unsigned long &numBytesRead)
-{
-  return m_stream->read(numBytes, numBytesRead);
-}
-
-int XorStream::seek(long offset, librevenge::RVNG_SEEK_TYPE seekType)
-{
-  return m_stream->seek(offset, seekType);
-}
-
-long XorStream::tell()
-{
-  return m_stream->tell();
-}
-
-bool XorStream::isEnd()
-{
-  return m_stream->isEnd();
-}
-
 void toggle(bool &value)
 {
   value = !value;
@@ -650,7 +548,7 @@ void parseEncodedText(MarkupParser *const parser, RVNGInputStream *input, EBOOKC
 
   if (converter)
   {
-    utf8Input.reset(new EBOOKUTF8Stream(input, converter));
+    utf8Input.reset(new EBOOKUTF8Stream(input, converter, EBOOKUTF8Stream::MODE_STREAMING));
     input = utf8Input.get();
   }
 
@@ -773,6 +671,29 @@ void PeanutPressParser::readDataRecord(librevenge::RVNGInputStream *record, bool
   (void) last;
 }
 
+void PeanutPressParser::unpackDataRecord(const unsigned char *const data, const unsigned long length, std::vector<char> &text) const
+{
+  switch (m_header->compression)
+  {
+  case PEANUTPRESS_COMPRESSION_LZ77 :
+    PDBLZ77Stream::unpack(data, length, 0, text);
+    break;
+  case PEANUTPRESS_COMPRESSION_LZ77_OBFUSCATED :
+  {
+    vector<unsigned char> unobfuscated(data, data + length);
+    for (vector<unsigned char>::iterator it = unobfuscated.begin(); unobfuscated.end() != it; ++it)
+      *it ^= 0xa5;
+    PDBLZ77Stream::unpack(unobfuscated.data(), length, 0, text);
+    break;
+  }
+  case PEANUTPRESS_COMPRESSION_ZLIB :
+  case PEANUTPRESS_COMPRESSION_UNKNOWN :
+  case PEANUTPRESS_COMPRESSION_DRM :
+  default :
+    text.assign(data, data + length);
+  }
+}
+
 void PeanutPressParser::readDataRecords()
 {
   readImages();
@@ -790,31 +711,14 @@ void PeanutPressParser::readText()
   switch (m_header->compression)
   {
   case PEANUTPRESS_COMPRESSION_LZ77 :
-    // TODO(check): doesn't this miss a record?
-    for (unsigned i = 1; i < lastTextRecord; ++i)
-    {
-      const unique_ptr<librevenge::RVNGInputStream> record(getDataRecord(i - 1));
-      if (bool(record))
-      {
-        PDBLZ77Stream compressedInput(record.get());
-        parseEncodedText(&parser, &compressedInput, &charsetConverter);
-      }
-      else
-      {
-        EBOOK_DEBUG_MSG(("could not get data record %u\n", i));
-      }
-    }
-    break;
   case PEANUTPRESS_COMPRESSION_LZ77_OBFUSCATED :
     // TODO(check): doesn't this miss a record?
     for (unsigned i = 1; i < lastTextRecord; ++i)
     {
-      const unique_ptr<librevenge::RVNGInputStream> record(getDataRecord(i - 1));
+      const unique_ptr<librevenge::RVNGInputStream> record(getUnpackedDataRecord(i - 1, CACHE_POLICY_DROP));
       if (bool(record))
       {
-        XorStream unobfuscatedInput(record.get(), 0xa5);
-        PDBLZ77Stream uncompressedInput(&unobfuscatedInput);
-        parseEncodedText(&parser, &uncompressedInput, &charsetConverter);
+        parseEncodedText(&parser, record.get(), &charsetConverter);
       }
       else
       {
@@ -829,6 +733,8 @@ void PeanutPressParser::readText()
     {
       EBOOKZlibStream uncompressedInput(block.get());
       parseEncodedText(&parser, &uncompressedInput, &charsetConverter);
+      if (uncompressedInput.hasFailed())
+        throw GenericException();
     }
     else
     {
@@ -1247,6 +1247,35 @@ void PluckerParser::readDataRecord(librevenge::RVNGInputStream *const record, bo
   (void) record;
 }
 
+void PluckerParser::unpackDataRecord(const unsigned char *const data, const unsigned long length, vector<char> &text) const
+{
+  // Only the text of compressed text records is unpacked; the record
+  // header and the paragraph lengths are kept as they are.
+  unsigned long headerLength = 0;
+  if ((8 <= length) && (DATA_TYPE_PHTML_COMPRESSED == data[6]))
+    headerLength = 8 + 4 * ((unsigned long)(data[2] << 8) | data[3]);
+
+  if ((0 == headerLength) || (length < headerLength))
+  {
+    text.assign(data, data + length);
+    return;
+  }
+
+  EBOOKMemoryStream packed(data + headerLength, unsigned(length - headerLength), EBOOKMemoryStream::DATA_OWNERSHIP_BORROW);
+  const shared_ptr<librevenge::RVNGInputStream> uncompressed(getUncompressedStream(&packed));
+
+  text.assign(data, data + headerLength);
+  if (bool(uncompressed))
+  {
+    const unsigned long uncompressedLength = getRemainingLength(uncompressed.get());
+    if (0 < uncompressedLength)
+    {
+      const unsigned char *const bytes = readNBytes(uncompressed.get(), uncompressedLength);
+      text.insert(text.end(), bytes, bytes + uncompressedLength);
+    }
+  }
+}
+
 void PluckerParser::readDataRecords()
 {
   vector<PluckerRecordHeader> textRecords;
@@ -1318,7 +1347,8 @@ void PluckerParser::readDataRecords()
 
   for (vector<PluckerRecordHeader>::const_iterator it = textRecords.begin(); it != textRecords.end(); ++it)
   {
-    const unique_ptr<librevenge::RVNGInputStream> record(getDataRecord(it->number));
+    // the text is unpacked by unpackDataRecord(); it is only read once
+    const unique_ptr<librevenge::RVNGInputStream> record(getUnpackedDataRecord(it->number, CACHE_POLICY_DROP));
 
     if (it->type==DATA_TYPE_PHTML || it->type==DATA_TYPE_PHTML_COMPRESSED)
     {
@@ -1333,13 +1363,6 @@ void PluckerParser::readDataRecords()
         skip(input, 2);
       }
 
-      shared_ptr<librevenge::RVNGInputStream> uncompressed;
-      if (DATA_TYPE_PHTML_COMPRESSED == it->type)
-      {
-        uncompressed = getUncompressedStream(input);
-        input = uncompressed.get();
-      }
-
       readText(input, *it, paraLengths);
 
       break;
@@ -1418,7 +1441,9 @@ std::shared_ptr<librevenge::RVNGInputStream> PluckerParser::getUncompressedStrea
   input->seek((long) pos, librevenge::RVNG_SEEK_SET);
   const unsigned char *bytes = readNBytes(input, length);
 
-  EBOOKMemoryStream data(bytes, static_cast<unsigned>(length));
+  // the LZ77 decompressor reads all data in constructor and the zlib
+  // stream is fully inflated below, so there is no need to copy them
+  EBOOKMemoryStream data(bytes, static_cast<unsigned>(length), EBOOKMemoryStream::DATA_OWNERSHIP_BORROW);
 
   shared_ptr<librevenge::RVNGInputStream> uncompressed;
   switch (m_header->compression)
@@ -1427,8 +1452,17 @@ std::shared_ptr<librevenge::RVNGInputStream> PluckerParser::getUncompressedStrea
     uncompressed.reset(new PDBLZ77Stream(&data));
     break;
   case COMPRESSION_ZLIB :
-    uncompressed.reset(new EBOOKZlibStream(&data));
+  {
+    EBOOKZlibStream inflated(&data);
+    const unsigned long inflatedLength = getRemainingLength(&inflated);
+    if (inflated.hasFailed())
+      throw GenericException();
+    if (0 < inflatedLength)
+      uncompressed.reset(new EBOOKMemoryStream(readNBytes(&inflated, inflatedLength), static_cast<unsigned>(inflatedLength)));
+    else
+      uncompressed.reset(new EBOOKMemoryStream());
     break;
+  }
   case COMPRESSION_UNKNOWN:
   default :
     // not possible
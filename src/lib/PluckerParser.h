@@ -41,6 +41,7 @@ private:
   void readSortInfoRecord(librevenge::RVNGInputStream *record) override;
   void readIndexRecord(librevenge::RVNGInputStream *record) override;
   void readDataRecord(librevenge::RVNGInputStream *record, bool last = false) override;
+  void unpackDataRecord(const unsigned char *data, unsigned long length, std::vector<char> &text) const override;
 
   void readDataRecords() override;
 
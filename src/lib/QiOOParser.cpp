@@ -11,6 +11,8 @@
 
 #include <cassert>
 
+#include "EBOOKByteCursor.h"
+
 namespace libebook
 {
 
@@ -30,9 +32,10 @@ void parseText(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInt
     // output paragraphs
     librevenge::RVNGString text;
     bool ignoreNextLineBreak = false;
-    while (!input->isEnd())
+    EBOOKByteCursor data(input);
+    while (!data.isEnd())
     {
-      const uint8_t c = readU8(input);
+      const uint8_t c = data.readU8();
       if (('\n' == c) || ('\r' == c))
       {
         if (ignoreNextLineBreak)
@@ -10,6 +10,7 @@
 #include <cassert>
 
 #include "libebook_xml.h"
+#include "EBOOKByteCursor.h"
 #include "RocketEBookHeader.h"
 
 #define ROCKETEBOOK_CODE(s) ((s[0] << 24) | (s[1] << 16) | (s[2] << 8) | s[3])
@@ -57,6 +58,35 @@ RocketEBookHeader::RocketEBookHeader(const RVNGInputStreamPtr_t &input)
   readDirectory(input);
 }
 
+bool RocketEBookHeader::isSupported(librevenge::RVNGInputStream *const input)
+{
+  if (!input || (0 != input->seek(0, librevenge::RVNG_SEEK_END)))
+    return false;
+  const long fileSize = input->tell();
+  if (0 != input->seek(0, librevenge::RVNG_SEEK_SET))
+    return false;
+
+  unsigned long readBytes = 0;
+  const unsigned char *const data = input->read(0x20, readBytes);
+  if (!data || (0x20 != readBytes))
+    return false;
+
+  // the whole header has been read, so the cursor cannot throw
+  EBOOKByteCursor header(data, readBytes);
+  if (SIGNATURE != header.readU32())
+    return false;
+  if (2 != header.readU16())
+    return false;
+  const unsigned sig2 = header.readU32();
+  if ((SIGNATURE2 != sig2) && (0 != sig2)) // some files have 0 here
+    return false;
+
+  header.seek(0x18);
+  const unsigned tocOffset = header.readU32();
+  const unsigned length = header.readU32();
+  return (fileSize - 0x20 == long(length)) && (length >= tocOffset);
+}
+
 unsigned RocketEBookHeader::getInfoID() const
 {
   return m_info;
@@ -69,26 +99,15 @@ const RocketEBookHeader::Directory_t &RocketEBookHeader::getDirectory() const
 
 void RocketEBookHeader::readHeader(const RVNGInputStreamPtr_t &input)
 {
-  const unsigned sig = readU32(input);
-  if (SIGNATURE != sig)
+  // the checks are only done in isSupported(), so they cannot diverge
+  if (!isSupported(input.get()))
     throw UnsupportedFormat();
 
+  seek(input, 4);
   m_version = readU16(input);
-  if (2 != m_version)
-    throw UnsupportedFormat();
-
-  const unsigned sig2 = readU32(input);
-  if ((SIGNATURE2 != sig2) && (0 != sig2)) // some files have 0 here
-    throw UnsupportedFormat();
-
-  skip(input, 4 + 4 + 6);
-  assert(0x18 == input->tell());
-
+  seek(input, 0x18);
   m_tocOffset = readU32(input);
   m_length = readU32(input);
-
-  if ((getRemainingLength(input) != m_length) || (m_length < m_tocOffset))
-    throw ParseError();
 }
 
 void RocketEBookHeader::readDirectory(const RVNGInputStreamPtr_t &input)
@@ -44,6 +44,10 @@ public:
 public:
   explicit RocketEBookHeader(const RVNGInputStreamPtr_t &input);
 
+  /** Check the header without throwing.
+    */
+  static bool isSupported(librevenge::RVNGInputStream *input);
+
   unsigned getInfoID() const;
   const Directory_t &getDirectory() const;
 
@@ -149,6 +149,11 @@ RocketEBookParser::RocketEBookParser(const RVNGInputStreamPtr_t &input, libreven
   assert(m_input);
 }
 
+bool RocketEBookParser::isSupported(librevenge::RVNGInputStream *const input)
+{
+  return RocketEBookHeader::isSupported(input);
+}
+
 void RocketEBookParser::parse()
 {
   if (!m_document)
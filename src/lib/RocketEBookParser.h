@@ -26,6 +26,10 @@ class RocketEBookParser
 public:
   explicit RocketEBookParser(const RVNGInputStreamPtr_t &input, librevenge::RVNGTextInterface *document = 0);
 
+  /** Check the header without throwing.
+    */
+  static bool isSupported(librevenge::RVNGInputStream *input);
+
   void parse();
 
 private:
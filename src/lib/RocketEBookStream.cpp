@@ -29,6 +29,9 @@ namespace libebook
 namespace
 {
 
+// all chunks but the last one are inflated to this size
+const unsigned CHUNK_SIZE = 0x1000;
+
 void uncompress(RVNGInputStream *stream, vector<unsigned char> &data)
 {
   const unsigned count = readU32(stream);
@@ -44,7 +47,8 @@ void uncompress(RVNGInputStream *stream, vector<unsigned char> &data)
   for (deque<unsigned>::const_iterator it = lengths.begin(); lengths.end() != it; ++it)
   {
     EBOOKStreamView compressed(stream, offset, *it);
-    EBOOKZlibStream uncompressed(&compressed);
+    const unsigned remaining = (length > data.size()) ? length - unsigned(data.size()) : 0;
+    EBOOKZlibStream uncompressed(&compressed, std::min(remaining, CHUNK_SIZE));
     const unsigned uncompressedLen = getRemainingLength(&uncompressed);
     const unsigned char *const uncompressedData = readNBytes(&uncompressed, uncompressedLen);
     data.insert(data.end(), uncompressedData, uncompressedData + uncompressedLen);
@@ -65,7 +69,7 @@ RVNGInputStream *makeSubStream(const RVNGInputStreamPtr_t &stream, const RocketE
     vector<unsigned char> data;
     EBOOKStreamView subStream(stream.get(), entry.offset, entry.length);
     uncompress(&subStream, data);
-    return new EBOOKMemoryStream(&data[0], data.size());
+    return new EBOOKMemoryStream(std::move(data));
   }
   else
   {
@@ -9,7 +9,7 @@
 
 #include <algorithm>
 #include <cassert>
-#include <memory>
+#include <cstring>
 #include <vector>
 
 #include "libebook_utils.h"
@@ -25,143 +25,96 @@ namespace libebook
 namespace
 {
 
-class SlidingWindow
-{
-  // -Weffc++
-  SlidingWindow(const SlidingWindow &other);
-  SlidingWindow &operator=(const SlidingWindow &other);
-
-public:
-  SlidingWindow(size_t size, unsigned char fill, unsigned fillPos, bool allowOverflow);
-
-  ~SlidingWindow();
-
-  void push(unsigned char byte);
-
-  void copyOut(size_t offset, size_t length, vector<unsigned char> &out);
-
-private:
-  void push(unsigned char *bytes, size_t length);
-
-  void advance();
-  void advance(size_t &pos, size_t increment = 1);
-
-private:
-  const std::unique_ptr<unsigned char[]> m_data;
-  const size_t m_size;
-  size_t m_begin;
-  size_t m_end;
-  bool m_growing;
-  bool m_allowOverflow;
-};
-
-SlidingWindow::SlidingWindow(const size_t size, const unsigned char fill, const unsigned fillPos, const bool allowOverflow)
-  : m_data(new unsigned char[size])
-  , m_size(size)
-  , m_begin(0)
-  , m_end(fillPos)
-  , m_growing(true)
-  , m_allowOverflow(allowOverflow)
-{
-  std::fill_n(m_data.get(), m_size, fill);
-}
-
-SlidingWindow::~SlidingWindow()
-{
-}
-
-void SlidingWindow::push(const unsigned char byte)
-{
-  m_data[m_end] = byte;
-  advance();
-}
-
-void SlidingWindow::copyOut(const size_t offset, const size_t length, vector<unsigned char> &out)
-{
-  size_t pos = m_begin;
-  advance(pos, offset);
-
-  if (m_growing && !m_allowOverflow && ((pos + length) > m_end))
-  {
-    for (size_t i = 0; i != length; ++i)
-      out.push_back(m_data[pos]);
-  }
-  else
-  {
-    for (size_t i = 0; i != length; ++i)
-    {
-      out.push_back(m_data[pos]);
-      advance(pos);
-    }
-  }
-
-  const size_t begin = out.size() - length;
-  push(&out[begin], length);
-}
-
-void SlidingWindow::push(unsigned char *const bytes, const size_t length)
-{
-  for (size_t i = 0; i != length; ++i)
-  {
-    m_data[m_end] = bytes[i];
-    advance();
-  }
-}
-
-void SlidingWindow::advance()
-{
-  advance(m_end, 1);
-  if (m_end == m_begin)
-    m_growing = false;
-  if (!m_growing)
-    advance(m_begin, 1);
-}
-
-void SlidingWindow::advance(size_t &pos, const size_t increment)
-{
-  if (0 == increment)
-    return;
-
-  pos = (pos + increment) % m_size;
-}
-
-}
-
-namespace
-{
-
 struct LZSSCompressionException {};
 
 struct LZSSException {};
 
+/** Unpack LZSS compressed data.
+  *
+  * The window is a ring buffer of 2^offsetBits bytes, which is
+  * initially filled with fillChar; the output starts at position
+  * fillPos. Every byte of the window is either a fill character or a
+  * copy of a byte of the output, so the output itself is used as the
+  * window.
+  */
 void unpack(librevenge::RVNGInputStream *const stream, const SoftBookLZSSStream::Configuration &configuration, vector<unsigned char> &buffer)
 {
   // the window size can normally be represented in 16 bits or less
   assert(24 > configuration.offsetBits);
 
-  EBOOKBitStream bitStream(stream);
+  const unsigned long windowSize = 1ul << configuration.offsetBits;
+  const unsigned long windowMask = windowSize - 1;
+  const unsigned long fillPos = configuration.fillPos;
+  const auto fillChar = static_cast<unsigned char>(configuration.fillChar);
+  const unsigned long maxLength = configuration.uncompressedLength;
+  const bool bigEndian = configuration.bigEndian;
 
-  SlidingWindow window(1 << configuration.offsetBits, (unsigned char)configuration.fillChar, configuration.fillPos, configuration.allowOverflow);
+  assert(fillPos < windowSize);
 
-  const unsigned maxLength = configuration.uncompressedLength;
-  const bool bigEndian = configuration.bigEndian;
+  const unsigned long packedLength = getRemainingLength(stream);
+  EBOOKBitStream bitStream(stream);
 
-  while ((0 < maxLength) ? (buffer.size() < maxLength) : !bitStream.atLastByte())
+  if (0 < maxLength)
+    buffer.resize(maxLength);
+  else
+    buffer.resize(2 * packedLength + 1);
+
+  unsigned long pos = 0; // the number of unpacked bytes
+  while ((0 < maxLength) ? (pos < maxLength) : !bitStream.atLastByte())
   {
-    const bool encoded = 0 == bitStream.read(1, bigEndian);
+    const bool encoded = 0 == bitStream.read(1);
     if (encoded)
     {
-      const uint32_t offset = bitStream.read((uint8_t) configuration.offsetBits, bigEndian);
-      const uint32_t length = bitStream.read((uint8_t) configuration.lengthBits, bigEndian) + 3;
-      window.copyOut(offset, length, buffer);
+      const unsigned long offset = bitStream.read((uint8_t) configuration.offsetBits, bigEndian);
+      const unsigned long length = bitStream.read((uint8_t) configuration.lengthBits, bigEndian) + 3;
+
+      // The window is full once the output reaches its beginning. Until
+      // then, offset is the position in the window; after that, it is
+      // relative to the byte following the current position.
+      const bool growing = (fillPos + pos) < windowSize;
+      const unsigned long from = growing ? offset : ((fillPos + pos + 1 + offset) & windowMask);
+
+      unsigned long count = length;
+      if (0 < maxLength)
+        count = std::min(count, maxLength - pos);
+      else if (buffer.size() - pos < count)
+        buffer.resize(2 * buffer.size() + count);
+
+      // The distance of the window position from the current position.
+      // Positions that have not been written yet contain fillChar.
+      const unsigned long distance = (from - fillPos - pos) & windowMask;
+
+      if (growing && !configuration.allowOverflow && ((offset + length) > (fillPos + pos)))
+      {
+        // the copy would reach data that have not been written yet
+        const unsigned char c = (pos + distance >= windowSize) ? buffer[pos + distance - windowSize] : fillChar;
+        std::memset(&buffer[pos], c, count);
+      }
+      else if ((distance + count <= windowSize) && (pos + distance >= windowSize))
+      {
+        // a contiguous part of the output, which ends before the current position
+        std::memcpy(&buffer[pos], &buffer[pos + distance - windowSize], count);
+      }
+      else
+      {
+        for (unsigned long i = 0; i != count; ++i)
+        {
+          const unsigned long d = (distance + i) & windowMask;
+          buffer[pos + i] = (pos + d >= windowSize) ? buffer[pos + d - windowSize] : fillChar;
+        }
+      }
+      pos += count;
     }
     else
     {
-      const auto c = static_cast<unsigned char>(bitStream.read(8, bigEndian));
-      buffer.push_back(c);
-      window.push(c);
+      const auto c = static_cast<unsigned char>(bitStream.read(8));
+      if (buffer.size() == pos)
+        buffer.resize(2 * buffer.size());
+      buffer[pos++] = c;
     }
   }
+
+  buffer.resize(pos);
 }
 
 }
@@ -188,7 +141,7 @@ SoftBookLZSSStream::SoftBookLZSSStream(librevenge::RVNGInputStream *const stream
   if (unpacked.empty())
     throw LZSSException();
 
-  m_stream.reset(new EBOOKMemoryStream(&unpacked[0], (unsigned) unpacked.size()));
+  m_stream.reset(new EBOOKMemoryStream(std::move(unpacked)));
 }
 
 SoftBookLZSSStream::~SoftBookLZSSStream()
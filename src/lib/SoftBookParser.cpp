@@ -190,6 +190,15 @@ SoftBookParser::SoftBookParser(librevenge::RVNGInputStream *const input, libreve
 {
 }
 
+SoftBookParser::SoftBookParser(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document, const SoftBookHeader &header)
+  : m_header(header)
+  , m_input(input)
+  , m_collector(document)
+  , m_resources()
+  , m_text()
+{
+}
+
 bool SoftBookParser::parse()
 {
   SoftBookResourceDir resourceDir(m_input, m_header);
@@ -24,6 +24,7 @@ class SoftBookParser
 
 public:
   SoftBookParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document);
+  SoftBookParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document, const SoftBookHeader &header);
 
   bool parse();
 
@@ -12,6 +12,7 @@
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "libebook_utils.h"
+#include "EBOOKByteCursor.h"
 #include "SoftBookCollector.h"
 #include "SoftBookText.h"
 
@@ -54,9 +55,11 @@ SoftBookText::SoftBookText(librevenge::RVNGInputStream *const input, SoftBookCol
 
 bool SoftBookText::parse()
 {
-  while (!m_input->isEnd())
+  EBOOKByteCursor input(m_input);
+
+  while (!input.isEnd())
   {
-    const unsigned char c = readU8(m_input);
+    const unsigned char c = input.readU8();
 
     switch (c)
     {
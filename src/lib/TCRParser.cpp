@@ -14,6 +14,7 @@
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "libebook_utils.h"
+#include "EBOOKByteCursor.h"
 #include "EBOOKCharsetConverter.h"
 #include "EBOOKMemoryStream.h"
 #include "EBOOKUTF8Stream.h"
@@ -37,13 +38,20 @@ TCRParser::TCRParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInt
   : m_input(input)
   , m_document(document)
 {
-  const size_t length = EBOOK_NUM_ELEMENTS(TCR_SIGNATURE) - 1; // without the final \0
-  input->seek(0, librevenge::RVNG_SEEK_SET);
-  const auto *const sig = reinterpret_cast<const char *>(readNBytes(input, length));
-  if (!std::equal(sig, sig + length, TCR_SIGNATURE))
+  if (!isSupported(input))
     throw UnsupportedFormat();
 }
 
+bool TCRParser::isSupported(librevenge::RVNGInputStream *const input)
+{
+  const size_t length = EBOOK_NUM_ELEMENTS(TCR_SIGNATURE) - 1; // without the final \0
+  if (!input || (0 != input->seek(0, librevenge::RVNG_SEEK_SET)))
+    return false;
+  unsigned long readBytes = 0;
+  const auto *const sig = reinterpret_cast<const char *>(input->read(length, readBytes));
+  return sig && (length == readBytes) && std::equal(sig, sig + length, TCR_SIGNATURE);
+}
+
 bool TCRParser::parse()
 {
   readReplacementTable();
@@ -79,11 +87,9 @@ shared_ptr<librevenge::RVNGInputStream> TCRParser::uncompress()
 {
   string text;
 
-  while (!m_input->isEnd())
-  {
-    const unsigned char c = readU8(m_input);
-    text.append(m_replacementTable[c]);
-  }
+  EBOOKByteCursor input(m_input);
+  while (!input.isEnd())
+    text.append(m_replacementTable[input.readU8()]);
 
   EBOOKCharsetConverter converter;
   const bool knownEncoding = converter.guessEncoding(text.data(), (unsigned) text.size());
@@ -102,10 +108,11 @@ void TCRParser::writeText(const shared_ptr<librevenge::RVNGInputStream> &input)
   assert(bool(input));
 
   string text;
+  EBOOKByteCursor data(input.get());
 
-  while (!input->isEnd())
+  while (!data.isEnd())
   {
-    const unsigned char c = readU8(input.get());
+    const unsigned char c = data.readU8();
     if ('\n' == c)
     {
       m_document->openParagraph(librevenge::RVNGPropertyList());
@@ -41,6 +41,12 @@ namespace
 
 static const unsigned TEALDOC_BLOCK_SIZE = 4096;
 
+/// The size of parts in which the text is read.
+static const unsigned long READ_CHUNK_SIZE = 0x10000;
+
+/// The max. length of a tag that is continued in the next record.
+static const unsigned long MAX_SPLIT_TAG_LENGTH = 1024;
+
 static const unsigned TEALDOC_TYPE = PDB_CODE("TEXt");
 static const unsigned TEALDOC_CREATOR = PDB_CODE("TlDc");
 
@@ -337,7 +343,14 @@ public:
   void parse(librevenge::RVNGInputStream *input, bool last = false);
 
 private:
-  bool parseTag(librevenge::RVNGInputStream *input);
+  /** Parse text in memory.
+    *
+    * @return the start of a tag that is continued in the next part, or
+    *         @c end if everything has been parsed
+    */
+  const char *parse(const char *begin, const char *end, bool last);
+
+  bool parseTag(const char *begin, const char *end);
 
   bool parseHeaderTag(const Attributes_t &attributeList);
 
@@ -350,6 +363,9 @@ private:
 private:
   librevenge::RVNGTextInterface *const m_document;
 
+  const TagGrammar<const char *> m_grammar; //< built once, as it is expensive to construct
+  vector<char> m_buffer; //< the input, starting with an unfinished tag from the previous part
+
   string m_text;
 
   bool m_openedParagraph;
@@ -357,6 +373,8 @@ private:
 
 TealDocTextParser::TealDocTextParser(librevenge::RVNGTextInterface *const document)
   : m_document(document)
+  , m_grammar()
+  , m_buffer()
   , m_text()
   , m_openedParagraph(false)
 {
@@ -364,72 +382,87 @@ TealDocTextParser::TealDocTextParser(librevenge::RVNGTextInterface *const docume
 
 void TealDocTextParser::parse(librevenge::RVNGInputStream *const input, const bool last)
 {
+  // The text is parsed from memory, so tags can be matched without
+  // reading them again.
   while (!input->isEnd())
   {
-    const unsigned char c = readU8(input);
-
-    switch (c)
-    {
-    case '\n' :
-      finishParagraph();
-      break;
-    case '<' :
-      if (!parseTag(input))
-        m_text.push_back('<');
+    unsigned long readBytes = 0;
+    const unsigned char *const data = input->read(READ_CHUNK_SIZE, readBytes);
+    if (!data || (0 == readBytes))
       break;
-    default :
-      m_text.push_back((char) c);
-    }
+    m_buffer.insert(m_buffer.end(), data, data + readBytes);
+  }
+
+  if (!m_buffer.empty())
+  {
+    const char *const begin = &m_buffer[0];
+    const char *const rest = parse(begin, begin + m_buffer.size(), last);
+    m_buffer.erase(m_buffer.begin(), m_buffer.begin() + (rest - begin));
   }
 
   if (last)
     finishParagraph();
 }
 
-bool TealDocTextParser::parseTag(librevenge::RVNGInputStream *const input)
+const char *TealDocTextParser::parse(const char *const begin, const char *const end, const bool last)
 {
-  const auto pos = (unsigned long) input->tell();
-  string tag("<");
-
-  // read tag into string
-  // I suppose it would be possible to create an iterator adaptor for
-  // librevenge::RVNGInputStream, but this is much simpler
-  unsigned char c = 0;
-  do
+  const char *current = begin;
+  while (current != end)
   {
-    c = readU8(input);
-    tag.push_back((char) c);
+    const char *special = current;
+    while ((special != end) && ('\n' != *special) && ('<' != *special))
+      ++special;
+    m_text.append(current, special);
+
+    if (special == end)
+      break;
+
+    if ('\n' == *special)
+    {
+      finishParagraph();
+      current = special + 1;
+    }
+    else
+    {
+      const auto *const tagEnd = static_cast<const char *>(std::memchr(special, '>', static_cast<size_t>(end - special)));
+      if (!tagEnd && !last && (static_cast<unsigned long>(end - special) < MAX_SPLIT_TAG_LENGTH))
+        return special;
+
+      if (tagEnd && parseTag(special, tagEnd + 1))
+      {
+        current = tagEnd + 1;
+      }
+      else
+      {
+        m_text.push_back('<');
+        current = special + 1;
+      }
+    }
   }
-  while ('>' != c);
 
-  // parse tag
+  return end;
+}
+
+bool TealDocTextParser::parseTag(const char *const begin, const char *const end)
+{
   std::pair<int, Attributes_t> parsedTag;
 
-  auto it = tag.cbegin();
-  const bool match = qi::phrase_parse(
-                       it, tag.cend(),
-                       TagGrammar<string::const_iterator>(), qi::space,
-                       parsedTag
-                     );
-  const bool success = match && it == tag.end();
+  const char *it = begin;
+  const bool match = qi::phrase_parse(it, end, m_grammar, qi::space, parsedTag);
+  if (!match || (it != end))
+    return false;
 
-  // process tag
-  if (success)
+  if (parsedTag.first == TOKEN_HEADER)
   {
-    if (parsedTag.first == TOKEN_HEADER)
-    {
-      finishParagraph();
-      parseHeaderTag(parsedTag.second);
-    }
-    /* TODO: handle TOKEN_TEALPAINT
-       ok to ignore: TOKEN_BOOKMARK, TOKEN_HRULE, TOKEN_LABEL, TOKEN_LINK
-       unknown 10 other enumerataions
-    */
+    finishParagraph();
+    parseHeaderTag(parsedTag.second);
   }
-  else
-    input->seek((long) pos, librevenge::RVNG_SEEK_SET);
+  /* TODO: handle TOKEN_TEALPAINT
+     ok to ignore: TOKEN_BOOKMARK, TOKEN_HRULE, TOKEN_LABEL, TOKEN_LINK
+     unknown 10 other enumerataions
+  */
 
-  return success;
+  return true;
 }
 
 bool TealDocTextParser::parseHeaderTag(const Attributes_t &attributeList)
@@ -549,7 +582,7 @@ TealDocParser::TealDocParser(librevenge::RVNGInputStream *input, librevenge::RVN
   , m_read(0)
   , m_openedDocument(false)
   , m_converter()
-  , m_textParser(new TealDocTextParser(document))
+  , m_textParser()
 {
 }
 
@@ -582,6 +615,9 @@ void TealDocParser::readIndexRecord(librevenge::RVNGInputStream *const input)
   m_recordCount = readU16(input, true);
   m_recordSize = readU16(input, true);
 
+  // the document might have been set after construction
+  m_textParser.reset(new TealDocTextParser(getDocument()));
+
   // check consistency
   assert(m_recordCount == getDataRecordCount());
   assert(TEALDOC_BLOCK_SIZE == m_recordSize);
@@ -597,14 +633,34 @@ void TealDocParser::readDataRecord(librevenge::RVNGInputStream *input, const boo
   // This should not happen, but it is the easier case anyway :-)
   if (m_compressed)
   {
-    compressedInput.reset(new PDBLZ77Stream(input));
+    compressedInput.reset(new PDBLZ77Stream(input, m_recordSize));
     input = compressedInput.get();
   }
 
-  const long origPos = input->tell();
   while (!input->isEnd())
     uncompressed.push_back((char) readU8(input));
-  m_read += unsigned(input->tell() - origPos);
+
+  readUnpackedDataRecord(uncompressed, last);
+}
+
+bool TealDocParser::canUnpackDataRecords() const
+{
+  // uncompressed records are used as they are
+  return m_compressed;
+}
+
+void TealDocParser::unpackDataRecord(const unsigned char *const data, const unsigned long length, vector<char> &text) const
+{
+  // getUnpackedDataRecord() calls this for uncompressed records too
+  if (m_compressed)
+    PDBLZ77Stream::unpack(data, length, m_recordSize, text);
+  else
+    text.assign(data, data + length);
+}
+
+void TealDocParser::readUnpackedDataRecord(const vector<char> &uncompressed, const bool last)
+{
+  m_read += unsigned(uncompressed.size());
 
   assert(m_read <= m_textLength);
   if (last)
@@ -616,8 +672,8 @@ void TealDocParser::readDataRecord(librevenge::RVNGInputStream *input, const boo
     openDocument();
   }
 
-  EBOOKMemoryStream uncompressedStrm(reinterpret_cast<unsigned char *>(&uncompressed[0]), (unsigned) uncompressed.size());
-  EBOOKUTF8Stream utf8Strm(&uncompressedStrm);
+  EBOOKMemoryStream uncompressedStrm(reinterpret_cast<const unsigned char *>(&uncompressed[0]), (unsigned) uncompressed.size());
+  EBOOKUTF8Stream utf8Strm(&uncompressedStrm, nullptr, EBOOKUTF8Stream::MODE_STREAMING);
 
   m_textParser->parse(&utf8Strm, last);
 
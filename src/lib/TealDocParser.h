@@ -40,6 +40,9 @@ private:
   void readSortInfoRecord(librevenge::RVNGInputStream *record) override;
   void readIndexRecord(librevenge::RVNGInputStream *record) override;
   void readDataRecord(librevenge::RVNGInputStream *record, bool last) override;
+  bool canUnpackDataRecords() const override;
+  void unpackDataRecord(const unsigned char *data, unsigned long length, std::vector<char> &text) const override;
+  void readUnpackedDataRecord(const std::vector<char> &text, bool last) override;
 
   void createConverter(const std::vector<char> &text);
 
@@ -11,6 +11,7 @@
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "libebook_utils.h"
+#include "EBOOKByteCursor.h"
 #include "EBOOKZlibStream.h"
 #include "ZTXTParser.h"
 
@@ -22,6 +23,8 @@ namespace libebook
 static const uint32_t ZTXT_TYPE = PDB_CODE("zTXT");
 static const uint32_t ZTXT_CREATOR = PDB_CODE("GPlm");
 
+static const unsigned long TEXT_PART_SIZE = 0x4000;
+
 ZTXTParser::ZTXTParser(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document)
   : PDBParser(input, document, ZTXT_TYPE, ZTXT_CREATOR)
   , m_recordCount(0)
@@ -55,16 +58,27 @@ void ZTXTParser::readIndexRecord(librevenge::RVNGInputStream *const record)
 void ZTXTParser::readDataRecord(librevenge::RVNGInputStream *const record, bool)
 {
   librevenge::RVNGString text;
+
+  // the text is inflated on demand, so read it by parts
   while (!record->isEnd())
   {
-    const uint8_t c = readU8(record);
-    if ('\n' == c)
+    unsigned long length = 0;
+    const unsigned char *const part = record->read(TEXT_PART_SIZE, length);
+    if (!part || (0 == length))
+      break;
+
+    EBOOKByteCursor data(part, length);
+    while (!data.isEnd())
     {
-      handleText(text);
-      text.clear();
+      const uint8_t c = data.readU8();
+      if ('\n' == c)
+      {
+        handleText(text);
+        text.clear();
+      }
+      else
+        text.append(char(c));
     }
-    else
-      text.append(char(c));
   }
 
   if (0 < text.len())
@@ -79,18 +93,31 @@ void ZTXTParser::readDataRecords()
   {
     EBOOKZlibStream input(block.get());
     readDataRecord(&input);
+    if (input.hasFailed())
+      throw GenericException();
   }
   closeDocument();
 }
 
-void ZTXTParser::openDocument()
+void ZTXTParser::readMetadata()
 {
+  // the name is the only metadata, so there is no need to inflate the text
   getDocument()->startDocument(librevenge::RVNGPropertyList());
+  getDocument()->setDocumentMetaData(getMetadata());
+  getDocument()->endDocument();
+}
 
+librevenge::RVNGPropertyList ZTXTParser::getMetadata() const
+{
   librevenge::RVNGPropertyList metadata;
   metadata.insert("dc:title", librevenge::RVNGString(getName()));
-  getDocument()->setDocumentMetaData(metadata);
+  return metadata;
+}
 
+void ZTXTParser::openDocument()
+{
+  getDocument()->startDocument(librevenge::RVNGPropertyList());
+  getDocument()->setDocumentMetaData(getMetadata());
   getDocument()->openPageSpan(getDefaultPageSpanPropList());
 }
 
@@ -29,8 +29,11 @@ public:
   void readDataRecord(librevenge::RVNGInputStream *record, bool = true) override;
 
   void readDataRecords() override;
+  void readMetadata() override;
 
 private:
+  librevenge::RVNGPropertyList getMetadata() const;
+
   void openDocument();
   void closeDocument();
   void handleText(const librevenge::RVNGString &text);
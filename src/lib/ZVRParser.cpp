@@ -33,13 +33,20 @@ const char ZVR_SIGNATURE[] = "!!Compressed!!\n";
 ZVRParser::ZVRParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document)
   : m_input(input)
   , m_document(document)
+{
+  if (!isSupported(input))
+    throw UnsupportedFormat();
+}
+
+bool ZVRParser::isSupported(librevenge::RVNGInputStream *const input)
 {
   // ignore the trailing \0
   const size_t length = EBOOK_NUM_ELEMENTS(ZVR_SIGNATURE) - 1;
-  input->seek(0, librevenge::RVNG_SEEK_SET);
-  const auto *const sig = reinterpret_cast<const char *>(readNBytes(input, length));
-  if (!std::equal(sig, sig + length, ZVR_SIGNATURE))
-    throw UnsupportedFormat();
+  if (!input || (0 != input->seek(0, librevenge::RVNG_SEEK_SET)))
+    return false;
+  unsigned long readBytes = 0;
+  const auto *const sig = reinterpret_cast<const char *>(input->read(length, readBytes));
+  return sig && (length == readBytes) && std::equal(sig, sig + length, ZVR_SIGNATURE);
 }
 
 bool ZVRParser::parse()
@@ -25,6 +25,10 @@ public:
 
   ZVRParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document = nullptr);
 
+  /** Check the file signature without throwing.
+    */
+  static bool isSupported(librevenge::RVNGInputStream *input);
+
   bool parse();
 
 private:
@@ -12,7 +12,10 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <libe-book/EBOOKMappedFileStream.h>
+
 #include "libebook_utils.h"
+#include "EBOOKMemoryStream.h"
 
 using std::string;
 
@@ -187,6 +190,11 @@ unsigned long getRemainingLength(librevenge::RVNGInputStream *const input)
   return end - begin;
 }
 
+bool isInMemory(librevenge::RVNGInputStream *const input)
+{
+  return dynamic_cast<EBOOKMemoryStream *>(input) || dynamic_cast<EBOOKMappedFileStream *>(input);
+}
+
 uint8_t readU8(const std::shared_ptr<librevenge::RVNGInputStream> input, bool)
 {
   return readU8(input.get());
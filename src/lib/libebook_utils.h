@@ -75,6 +75,10 @@ void seekRelative(librevenge::RVNGInputStream *input, long pos);
 
 unsigned long getRemainingLength(librevenge::RVNGInputStream *input);
 
+/** Check if data read from the stream stay valid until it is destroyed.
+  */
+bool isInMemory(librevenge::RVNGInputStream *input);
+
 uint8_t readU8(std::shared_ptr<librevenge::RVNGInputStream> input, bool = false);
 uint16_t readU16(std::shared_ptr<librevenge::RVNGInputStream> input, bool bigEndian=false);
 uint32_t readU32(std::shared_ptr<librevenge::RVNGInputStream> input, bool bigEndian=false);
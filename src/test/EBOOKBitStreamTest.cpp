@@ -37,6 +37,8 @@ private:
   CPPUNIT_TEST(testReadVaryingBig);
 
   CPPUNIT_TEST(testAtLastByte);
+  CPPUNIT_TEST(testPeek);
+  CPPUNIT_TEST(testReadLong);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -56,6 +58,8 @@ private:
   void testReadVaryingSmall(bool bigEndian);
 
   void testAtLastByte();
+  void testPeek();
+  void testReadLong();
 };
 
 namespace
@@ -335,6 +339,47 @@ void EBOOKBitStreamTest::testAtLastByte()
   CPPUNIT_ASSERT(bitStream.isEnd());
 }
 
+void EBOOKBitStreamTest::testPeek()
+{
+  EBOOKBitStream bitStream(TEST_DATA, sizeof TEST_DATA);
+
+  CPPUNIT_ASSERT_EQUAL(0u, bitStream.peek(0));
+  CPPUNIT_ASSERT_EQUAL(7u, bitStream.peek(3));
+  CPPUNIT_ASSERT_EQUAL(0xe38eu, bitStream.peek(16));
+  bitStream.consume(3);
+  CPPUNIT_ASSERT_EQUAL(0x38e38e3u, bitStream.peek(29));
+  bitStream.consume(20);
+  CPPUNIT_ASSERT_EQUAL(0u, bitStream.read(1, true));
+  CPPUNIT_ASSERT(bitStream.atLastByte());
+
+  // the missing bits are 0
+  CPPUNIT_ASSERT_EQUAL(0xe30u, bitStream.peek(12));
+  CPPUNIT_ASSERT_THROW(bitStream.consume(9), libebook::EndOfStreamException);
+  bitStream.consume(8);
+  CPPUNIT_ASSERT(bitStream.isEnd());
+  CPPUNIT_ASSERT_EQUAL(0u, bitStream.peek(32));
+  CPPUNIT_ASSERT_THROW(bitStream.read(1), libebook::EndOfStreamException);
+}
+
+void EBOOKBitStreamTest::testReadLong()
+{
+  // more than the bit buffer can hold
+  const unsigned char data[] =
+  {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10, 0xff
+  };
+  EBOOKBitStream bitStream(data, sizeof data);
+
+  CPPUNIT_ASSERT_EQUAL(0u, bitStream.read(4, true));
+  CPPUNIT_ASSERT_EQUAL(0x12345678u, bitStream.read(32, true));
+  CPPUNIT_ASSERT_EQUAL(0x9abcdefu, bitStream.read(28, true));
+  CPPUNIT_ASSERT_EQUAL(0xfedcba98u, bitStream.read(32, true));
+  CPPUNIT_ASSERT_EQUAL(0x5476u, bitStream.read(16, false));
+  CPPUNIT_ASSERT_EQUAL(0x3210u, bitStream.read(16, true));
+  CPPUNIT_ASSERT_EQUAL(0xffu, bitStream.read(8, false));
+  CPPUNIT_ASSERT(bitStream.isEnd());
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKBitStreamTest);
 
 }
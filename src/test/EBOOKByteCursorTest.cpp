@@ -0,0 +1,136 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "libebook_utils.h"
+#include "EBOOKByteCursor.h"
+#include "EBOOKMemoryStream.h"
+
+using libebook::EBOOKBigEndian;
+using libebook::EBOOKByteCursor;
+using libebook::EBOOKMemoryStream;
+using libebook::EndOfStreamException;
+
+namespace test
+{
+
+class EBOOKByteCursorTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(EBOOKByteCursorTest);
+  CPPUNIT_TEST(testRead);
+  CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST(testBounds);
+  CPPUNIT_TEST(testFromStream);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testRead();
+  void testSeek();
+  void testBounds();
+  void testFromStream();
+};
+
+void EBOOKByteCursorTest::setUp()
+{
+}
+
+void EBOOKByteCursorTest::tearDown()
+{
+}
+
+void EBOOKByteCursorTest::testRead()
+{
+  const unsigned char data[] = { 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd };
+  EBOOKByteCursor cursor(data, sizeof(data));
+
+  CPPUNIT_ASSERT(!cursor.isEnd());
+  CPPUNIT_ASSERT_EQUAL(sizeof(data), size_t(cursor.getLength()));
+
+  CPPUNIT_ASSERT_EQUAL(uint8_t(0x1), cursor.readU8());
+  CPPUNIT_ASSERT_EQUAL(uint16_t(0x0302), cursor.readU16());
+  CPPUNIT_ASSERT_EQUAL(uint16_t(0x0405), cursor.readU16<EBOOKBigEndian>());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(0x09080706), cursor.readU32());
+  CPPUNIT_ASSERT_EQUAL(uint32_t(0x0a0b0c0d), cursor.readU32<EBOOKBigEndian>());
+
+  CPPUNIT_ASSERT(cursor.isEnd());
+  CPPUNIT_ASSERT_EQUAL(sizeof(data), size_t(cursor.tell()));
+}
+
+void EBOOKByteCursorTest::testSeek()
+{
+  const unsigned char data[] = "abc dee fgh";
+  EBOOKByteCursor cursor(data, sizeof(data));
+
+  cursor.skip(2);
+  CPPUNIT_ASSERT_EQUAL(2ul, cursor.tell());
+  CPPUNIT_ASSERT_EQUAL(uint8_t('c'), cursor.readU8());
+  cursor.seekRelative(-2);
+  CPPUNIT_ASSERT_EQUAL(1ul, cursor.tell());
+  cursor.seek(4);
+  CPPUNIT_ASSERT_EQUAL(4ul, cursor.tell());
+  CPPUNIT_ASSERT_EQUAL(sizeof(data) - 4, size_t(cursor.getRemainingLength()));
+
+  const unsigned char *const s = cursor.readNBytes(3);
+  CPPUNIT_ASSERT_MESSAGE("data have been copied", (data + 4) == s);
+
+  cursor.seek(sizeof(data));
+  CPPUNIT_ASSERT(cursor.isEnd());
+}
+
+void EBOOKByteCursorTest::testBounds()
+{
+  const unsigned char data[] = { 0x1, 0x2, 0x3 };
+  EBOOKByteCursor cursor(data, sizeof(data));
+
+  CPPUNIT_ASSERT_THROW(cursor.readU32(), EndOfStreamException);
+  CPPUNIT_ASSERT_EQUAL(0ul, cursor.tell()); // a failed read does not move the cursor
+  CPPUNIT_ASSERT_THROW(cursor.readNBytes(4), EndOfStreamException);
+  CPPUNIT_ASSERT_THROW(cursor.skip(4), EndOfStreamException);
+  CPPUNIT_ASSERT_THROW(cursor.seek(4), EndOfStreamException);
+  CPPUNIT_ASSERT_THROW(cursor.seekRelative(-1), EndOfStreamException);
+
+  cursor.skip(2);
+  CPPUNIT_ASSERT_THROW(cursor.readU16(), EndOfStreamException);
+  CPPUNIT_ASSERT_EQUAL(uint8_t(0x3), cursor.readU8());
+  CPPUNIT_ASSERT_THROW(cursor.readU8(), EndOfStreamException);
+
+  EBOOKByteCursor empty;
+  CPPUNIT_ASSERT(empty.isEnd());
+  CPPUNIT_ASSERT_THROW(empty.readU8(), EndOfStreamException);
+}
+
+void EBOOKByteCursorTest::testFromStream()
+{
+  const unsigned char data[] = "abc dee fgh";
+  EBOOKMemoryStream strm(data, sizeof(data), EBOOKMemoryStream::DATA_OWNERSHIP_BORROW);
+  strm.seek(4, librevenge::RVNG_SEEK_SET);
+
+  EBOOKByteCursor cursor(&strm);
+  CPPUNIT_ASSERT(strm.isEnd());
+  CPPUNIT_ASSERT_EQUAL(sizeof(data) - 4, size_t(cursor.getLength()));
+  CPPUNIT_ASSERT_MESSAGE("data have been copied", (data + 4) == cursor.readNBytes(1));
+
+  EBOOKByteCursor emptyCursor(&strm);
+  CPPUNIT_ASSERT(emptyCursor.isEnd());
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKByteCursorTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
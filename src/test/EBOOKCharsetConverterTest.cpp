@@ -0,0 +1,238 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <string>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "EBOOKCharsetConverter.h"
+
+using libebook::EBOOKCharsetConverter;
+
+using std::string;
+using std::vector;
+
+namespace test
+{
+
+namespace
+{
+
+string makeUTF8Text(const unsigned length)
+{
+  const string words[] =
+  {
+    "P\xc5\x99\xc3\xadli\xc5\xa1 ", "\xc5\xbelu\xc5\xa5ou\xc4\x8dk\xc3\xbd ", "k\xc5\xaf\xc5\x88 ", "\xc3\xbap\xc4\x9bl ",
+    "\xc4\x8f\xc3\xa1" "belsk\xc3\xa9 ", "\xc3\xb3" "dy. "
+  };
+
+  string text;
+  for (unsigned i = 0; text.size() < length; ++i)
+    text.append(words[i % 6]);
+  return text;
+}
+
+string convert(EBOOKCharsetConverter &converter, const string &text)
+{
+  vector<char> out;
+  CPPUNIT_ASSERT(converter.convertBytes(text.data(), unsigned(text.size()), out));
+  return string(out.begin(), out.end());
+}
+
+}
+
+class EBOOKCharsetConverterTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(EBOOKCharsetConverterTest);
+  CPPUNIT_TEST(testCache);
+  CPPUNIT_TEST(testConvert);
+  CPPUNIT_TEST(testConvertGrowing);
+  CPPUNIT_TEST(testConvertPassThrough);
+  CPPUNIT_TEST(testGuessEncoding);
+  CPPUNIT_TEST(testGuessEncodingLong);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testCache();
+  void testConvert();
+  void testConvertGrowing();
+  void testConvertPassThrough();
+  void testGuessEncoding();
+  void testGuessEncodingLong();
+};
+
+void EBOOKCharsetConverterTest::setUp()
+{
+}
+
+void EBOOKCharsetConverterTest::tearDown()
+{
+}
+
+void EBOOKCharsetConverterTest::testCache()
+{
+  {
+    // leave a partial character in the converter
+    EBOOKCharsetConverter converter("UTF-16BE");
+    const char text[] = "\0a\0";
+    const char *in = text;
+    char out[10];
+    char *outText = out;
+    CPPUNIT_ASSERT(converter.convertPart(in, text + 3, outText, out + sizeof(out), false));
+    CPPUNIT_ASSERT_EQUAL(string("a"), string(out, outText));
+  }
+
+  const EBOOKCharsetConverter::CacheStatistics before = EBOOKCharsetConverter::getCacheStatistics();
+
+  {
+    // both converters are reused and their state is reset
+    EBOOKCharsetConverter converter("UTF-16BE");
+    const char text[] = "\0b";
+    const char *in = text;
+    char out[10];
+    char *outText = out;
+    CPPUNIT_ASSERT(converter.convertPart(in, text + 2, outText, out + sizeof(out), true));
+    CPPUNIT_ASSERT_EQUAL(string("b"), string(out, outText));
+  }
+
+  const EBOOKCharsetConverter::CacheStatistics after = EBOOKCharsetConverter::getCacheStatistics();
+  CPPUNIT_ASSERT_EQUAL(before.hits + 2, after.hits);
+  CPPUNIT_ASSERT_EQUAL(before.misses, after.misses);
+}
+
+void EBOOKCharsetConverterTest::testConvert()
+{
+  EBOOKCharsetConverter converter("cp1252");
+  CPPUNIT_ASSERT_EQUAL(string("caf\xc3\xa9 cr\xc3\xa8me"), convert(converter, "caf\xe9 cr\xe8me"));
+  CPPUNIT_ASSERT_EQUAL(0u, converter.getGuessSampleSize());
+}
+
+void EBOOKCharsetConverterTest::testConvertGrowing()
+{
+  // the output is longer than the estimate, so the conversion must be
+  // resumed after the buffer is grown
+  {
+    string text;
+    string utf8;
+    for (unsigned i = 0; 1000 != i; ++i)
+    {
+      // U+1F600
+      text.append("\0\x01\xf6\0", 4);
+      utf8.append("\xf0\x9f\x98\x80");
+    }
+
+    EBOOKCharsetConverter converter("UTF-32BE");
+    CPPUNIT_ASSERT_EQUAL(utf8, convert(converter, text));
+  }
+
+  {
+    string text;
+    string utf8;
+    for (unsigned i = 0; 100000 != i; ++i)
+    {
+      // U+4E2D
+      text.append("\x4e\x2d");
+      utf8.append("\xe4\xb8\xad");
+    }
+
+    EBOOKCharsetConverter converter("UTF-16BE");
+    CPPUNIT_ASSERT_EQUAL(utf8, convert(converter, text));
+  }
+
+  // a reused buffer is shrunk to the result
+  {
+    EBOOKCharsetConverter converter("cp1252");
+    vector<char> out(100000, 'x');
+    CPPUNIT_ASSERT(converter.convertBytes("\xe9t\xe9", 3, out));
+    CPPUNIT_ASSERT_EQUAL(string("\xc3\xa9t\xc3\xa9"), string(out.begin(), out.end()));
+  }
+}
+
+void EBOOKCharsetConverterTest::testConvertPassThrough()
+{
+  vector<char> out;
+  unsigned outLength = 0;
+
+  {
+    EBOOKCharsetConverter converter("UTF-8");
+    const string text(makeUTF8Text(100));
+    CPPUNIT_ASSERT(text.data() == converter.convertBytes(text.data(), unsigned(text.size()), out, outLength));
+    CPPUNIT_ASSERT_EQUAL(unsigned(text.size()), outLength);
+    CPPUNIT_ASSERT(out.empty());
+
+    // invalid UTF-8 is converted
+    const string invalid("caf\xe9");
+    const char *const converted = converter.convertBytes(invalid.data(), unsigned(invalid.size()), out, outLength);
+    CPPUNIT_ASSERT(converted);
+    CPPUNIT_ASSERT(invalid.data() != converted);
+    CPPUNIT_ASSERT_EQUAL(string("caf\xef\xbf\xbd"), string(converted, outLength));
+  }
+
+  {
+    EBOOKCharsetConverter converter("cp1252");
+    const string ascii("cafe creme");
+    CPPUNIT_ASSERT(ascii.data() == converter.convertBytes(ascii.data(), unsigned(ascii.size()), out, outLength));
+    CPPUNIT_ASSERT_EQUAL(unsigned(ascii.size()), outLength);
+    CPPUNIT_ASSERT_EQUAL(ascii, convert(converter, ascii));
+
+    const string text("caf\xe9");
+    const char *const converted = converter.convertBytes(text.data(), unsigned(text.size()), out, outLength);
+    CPPUNIT_ASSERT(converted);
+    CPPUNIT_ASSERT_EQUAL(string("caf\xc3\xa9"), string(converted, outLength));
+  }
+
+  {
+    // ASCII bytes do not stand for ASCII characters here
+    EBOOKCharsetConverter converter("UTF-16BE");
+    const string text("\0a\0b", 4);
+    const char *const converted = converter.convertBytes(text.data(), unsigned(text.size()), out, outLength);
+    CPPUNIT_ASSERT(converted);
+    CPPUNIT_ASSERT_EQUAL(string("ab"), string(converted, outLength));
+  }
+}
+
+void EBOOKCharsetConverterTest::testGuessEncoding()
+{
+  const string text(makeUTF8Text(1000));
+
+  EBOOKCharsetConverter converter;
+  CPPUNIT_ASSERT(converter.guessEncoding(text.data(), unsigned(text.size())));
+  CPPUNIT_ASSERT_EQUAL(string("UTF-8"), string(converter.getEncoding()));
+  CPPUNIT_ASSERT_EQUAL(unsigned(text.size()), converter.getGuessSampleSize());
+  CPPUNIT_ASSERT(0 < converter.getGuessConfidence());
+  CPPUNIT_ASSERT_EQUAL(text, convert(converter, text));
+}
+
+void EBOOKCharsetConverterTest::testGuessEncodingLong()
+{
+  // the truncated character at the end makes the text invalid UTF-8,
+  // so the detector has to be used
+  const string text(makeUTF8Text(1000000));
+  const string truncated(text + "\xc5");
+
+  EBOOKCharsetConverter converter;
+  CPPUNIT_ASSERT(converter.guessEncoding(truncated.data(), unsigned(truncated.size())));
+  CPPUNIT_ASSERT_EQUAL(string("UTF-8"), string(converter.getEncoding()));
+  CPPUNIT_ASSERT(0x10000 >= converter.getGuessSampleSize());
+  CPPUNIT_ASSERT(0 < converter.getGuessConfidence());
+  CPPUNIT_ASSERT_EQUAL(text, convert(converter, text));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKCharsetConverterTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,136 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include <libe-book/EBOOKMappedFileStream.h>
+
+using libebook::EBOOKMappedFileStream;
+
+namespace test
+{
+
+namespace
+{
+
+const unsigned char DATA[] = "abc dee fgh";
+
+}
+
+class EBOOKMappedFileStreamTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(EBOOKMappedFileStreamTest);
+  CPPUNIT_TEST(testOpen);
+  CPPUNIT_TEST(testRead);
+  CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testOpen();
+  void testRead();
+  void testSeek();
+
+private:
+  std::string m_filename;
+};
+
+void EBOOKMappedFileStreamTest::setUp()
+{
+  m_filename = "EBOOKMappedFileStreamTest.tmp";
+  FILE *const file = std::fopen(m_filename.c_str(), "wb");
+  CPPUNIT_ASSERT(file);
+  CPPUNIT_ASSERT(sizeof(DATA) == std::fwrite(DATA, 1, sizeof(DATA), file));
+  std::fclose(file);
+}
+
+void EBOOKMappedFileStreamTest::tearDown()
+{
+  std::remove(m_filename.c_str());
+}
+
+void EBOOKMappedFileStreamTest::testOpen()
+{
+  {
+    EBOOKMappedFileStream strm(m_filename.c_str());
+    CPPUNIT_ASSERT(strm.isOpen());
+    CPPUNIT_ASSERT(!strm.isStructured());
+    CPPUNIT_ASSERT(!strm.isEnd());
+  }
+
+  {
+    EBOOKMappedFileStream strm("EBOOKMappedFileStreamTest.nonexistent");
+    CPPUNIT_ASSERT(!strm.isOpen());
+    CPPUNIT_ASSERT(strm.isEnd());
+    unsigned long readBytes = 1;
+    CPPUNIT_ASSERT(!strm.read(1, readBytes));
+    CPPUNIT_ASSERT(0 == readBytes);
+  }
+}
+
+void EBOOKMappedFileStreamTest::testRead()
+{
+  EBOOKMappedFileStream strm(m_filename.c_str());
+
+  for (int i = 0; sizeof(DATA) != i; ++i)
+  {
+    unsigned long readBytes = 0;
+    const unsigned char *s = strm.read(1, readBytes);
+
+    CPPUNIT_ASSERT(1 == readBytes);
+    CPPUNIT_ASSERT_EQUAL(DATA[i], s[0]);
+    CPPUNIT_ASSERT(((sizeof(DATA) - 1) == i) || !strm.isEnd());
+  }
+
+  CPPUNIT_ASSERT_MESSAGE("reading did not exhaust the stream", strm.isEnd());
+
+  strm.seek(0, librevenge::RVNG_SEEK_SET);
+
+  unsigned long readBytes = 0;
+  const unsigned char *s = strm.read(sizeof(DATA) + 10, readBytes);
+  CPPUNIT_ASSERT(sizeof(DATA) == readBytes);
+  CPPUNIT_ASSERT(std::equal(DATA, DATA + sizeof(DATA), s));
+  CPPUNIT_ASSERT(strm.isEnd());
+}
+
+void EBOOKMappedFileStreamTest::testSeek()
+{
+  EBOOKMappedFileStream strm(m_filename.c_str());
+
+  CPPUNIT_ASSERT(0 == strm.seek(2, librevenge::RVNG_SEEK_SET));
+  CPPUNIT_ASSERT(2 == strm.tell());
+  CPPUNIT_ASSERT(0 == strm.seek(1, librevenge::RVNG_SEEK_CUR));
+  CPPUNIT_ASSERT(3 == strm.tell());
+  CPPUNIT_ASSERT(0 == strm.seek(-2, librevenge::RVNG_SEEK_CUR));
+  CPPUNIT_ASSERT(1 == strm.tell());
+
+  CPPUNIT_ASSERT(0 == strm.seek(0, librevenge::RVNG_SEEK_END));
+  CPPUNIT_ASSERT(strm.isEnd());
+  CPPUNIT_ASSERT(sizeof(DATA) == strm.tell());
+  CPPUNIT_ASSERT(0 != strm.seek(1, librevenge::RVNG_SEEK_END)); // cannot seek after the end
+  CPPUNIT_ASSERT(0 != strm.seek(-1, librevenge::RVNG_SEEK_SET)); // or before the start
+  CPPUNIT_ASSERT(sizeof(DATA) == strm.tell());
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKMappedFileStreamTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
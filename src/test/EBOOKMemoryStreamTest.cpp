@@ -8,6 +8,8 @@
  */
 
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
@@ -31,11 +33,13 @@ private:
   CPPUNIT_TEST_SUITE(EBOOKMemoryStreamTest);
   CPPUNIT_TEST(testRead);
   CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST(testOwnership);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testRead();
   void testSeek();
+  void testOwnership();
 };
 
 void EBOOKMemoryStreamTest::setUp()
@@ -99,6 +103,49 @@ void EBOOKMemoryStreamTest::testSeek()
   CPPUNIT_ASSERT((sizeof(data) - 1) == strm.tell());
 }
 
+void EBOOKMemoryStreamTest::testOwnership()
+{
+  const unsigned char data[] = "abc dee fgh";
+  unsigned long readBytes = 0;
+
+  {
+    EBOOKMemoryStream strm(data, sizeof(data));
+    const unsigned char *const s = strm.read(sizeof(data), readBytes);
+    CPPUNIT_ASSERT(sizeof(data) == readBytes);
+    CPPUNIT_ASSERT_MESSAGE("data have not been copied", data != s);
+    CPPUNIT_ASSERT(std::equal(data, data + sizeof(data), s));
+  }
+
+  {
+    EBOOKMemoryStream strm(data, sizeof(data), EBOOKMemoryStream::DATA_OWNERSHIP_BORROW);
+    const unsigned char *const s = strm.read(sizeof(data), readBytes);
+    CPPUNIT_ASSERT(sizeof(data) == readBytes);
+    CPPUNIT_ASSERT_MESSAGE("borrowed data have been copied", data == s);
+  }
+
+  {
+    std::vector<unsigned char> vec(data, data + sizeof(data));
+    const unsigned char *const vecData = &vec[0];
+    EBOOKMemoryStream strm(std::move(vec));
+    const unsigned char *const s = strm.read(sizeof(data), readBytes);
+    CPPUNIT_ASSERT(sizeof(data) == readBytes);
+    CPPUNIT_ASSERT_MESSAGE("moved data have been copied", vecData == s);
+    CPPUNIT_ASSERT(std::equal(data, data + sizeof(data), s));
+  }
+
+  {
+    std::shared_ptr<const unsigned char> buffer(new unsigned char[sizeof(data)], std::default_delete<unsigned char[]>());
+    std::copy(data, data + sizeof(data), const_cast<unsigned char *>(buffer.get()));
+    const unsigned char *const bufferData = buffer.get();
+    EBOOKMemoryStream strm(buffer, sizeof(data));
+    buffer.reset();
+    const unsigned char *const s = strm.read(sizeof(data), readBytes);
+    CPPUNIT_ASSERT(sizeof(data) == readBytes);
+    CPPUNIT_ASSERT_MESSAGE("shared data have been copied", bufferData == s);
+    CPPUNIT_ASSERT(std::equal(data, data + sizeof(data), s));
+  }
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKMemoryStreamTest);
 
 }
@@ -0,0 +1,172 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <string>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "EBOOKUTF8Scan.h"
+
+using libebook::convertUTF16LEToUTF8;
+using libebook::findNonASCII;
+using libebook::isASCII;
+using libebook::isValidUTF8;
+
+using std::string;
+using std::vector;
+
+namespace test
+{
+
+namespace
+{
+
+bool isValid(const string &text)
+{
+  return isValidUTF8(text.data(), text.size());
+}
+
+string fromUTF16LE(const string &text)
+{
+  vector<char> out;
+  convertUTF16LEToUTF8(reinterpret_cast<const unsigned char *>(text.data()), text.size(), out);
+  return string(out.begin(), out.end());
+}
+
+}
+
+class EBOOKUTF8ScanTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(EBOOKUTF8ScanTest);
+  CPPUNIT_TEST(testConvertUTF16LE);
+  CPPUNIT_TEST(testFindNonASCII);
+  CPPUNIT_TEST(testValidUTF8);
+  CPPUNIT_TEST(testInvalidUTF8);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testConvertUTF16LE();
+  void testFindNonASCII();
+  void testValidUTF8();
+  void testInvalidUTF8();
+};
+
+void EBOOKUTF8ScanTest::setUp()
+{
+}
+
+void EBOOKUTF8ScanTest::tearDown()
+{
+}
+
+void EBOOKUTF8ScanTest::testConvertUTF16LE()
+{
+  CPPUNIT_ASSERT_EQUAL(string(), fromUTF16LE(""));
+  CPPUNIT_ASSERT_EQUAL(string("a"), fromUTF16LE(string("a\0", 2)));
+
+  // a long ASCII run followed by all lengths of UTF-8 sequences
+  string text;
+  string utf8;
+  for (unsigned i = 0; 40 != i; ++i)
+  {
+    text.append(1, char('a' + i % 26)).append(1, '\0');
+    utf8.append(1, char('a' + i % 26));
+  }
+  text.append("\x7e\x01" "\x2d\x4e" "\x3d\xd8\x00\xde", 8);
+  utf8.append("\xc5\xbe" "\xe4\xb8\xad" "\xf0\x9f\x98\x80");
+  CPPUNIT_ASSERT_EQUAL(utf8, fromUTF16LE(text));
+
+  // a BOM is kept
+  CPPUNIT_ASSERT_EQUAL(string("\xef\xbb\xbf" "a"), fromUTF16LE(string("\xff\xfe" "a\0", 4)));
+
+  // invalid input is replaced by U+FFFD
+  CPPUNIT_ASSERT_EQUAL(string("\xef\xbf\xbd" "a"), fromUTF16LE(string("\x00\xdc" "a\0", 4)));
+  CPPUNIT_ASSERT_EQUAL(string("\xef\xbf\xbd" "a"), fromUTF16LE(string("\x3d\xd8" "a\0", 4)));
+  CPPUNIT_ASSERT_EQUAL(string("a\xef\xbf\xbd"), fromUTF16LE(string("a\0\x3d\xd8", 4)));
+  CPPUNIT_ASSERT_EQUAL(string("a\xef\xbf\xbd"), fromUTF16LE(string("a\0b", 3)));
+  CPPUNIT_ASSERT_EQUAL(string("\xef\xbf\xbd"), fromUTF16LE(string("\x3d\xd8\0", 3)));
+}
+
+void EBOOKUTF8ScanTest::testFindNonASCII()
+{
+  CPPUNIT_ASSERT_EQUAL(0ul, findNonASCII("", 0));
+  CPPUNIT_ASSERT(isASCII("", 0));
+
+  // check all positions, to get through both the block and the byte loops
+  for (unsigned long length = 1; 100 != length; ++length)
+  {
+    string text(length, 'a');
+    CPPUNIT_ASSERT(isASCII(text.data(), text.size()));
+    CPPUNIT_ASSERT_EQUAL(length, findNonASCII(text.data(), text.size()));
+
+    for (unsigned long pos = 0; length != pos; ++pos)
+    {
+      text[pos] = '\x80';
+      CPPUNIT_ASSERT_EQUAL(pos, findNonASCII(text.data(), text.size()));
+      CPPUNIT_ASSERT(!isASCII(text.data(), text.size()));
+      text[pos] = '\xff';
+      CPPUNIT_ASSERT_EQUAL(pos, findNonASCII(text.data(), text.size()));
+      text[pos] = '\x7f';
+    }
+  }
+}
+
+void EBOOKUTF8ScanTest::testValidUTF8()
+{
+  CPPUNIT_ASSERT(isValid(""));
+  CPPUNIT_ASSERT(isValid("plain ASCII text"));
+  CPPUNIT_ASSERT(isValid("\xc2\x80"));
+  CPPUNIT_ASSERT(isValid("\xdf\xbf"));
+  CPPUNIT_ASSERT(isValid("\xe0\xa0\x80"));
+  CPPUNIT_ASSERT(isValid("\xed\x9f\xbf"));
+  CPPUNIT_ASSERT(isValid("\xef\xbb\xbf" "BOM"));
+  CPPUNIT_ASSERT(isValid("\xf0\x90\x80\x80"));
+  CPPUNIT_ASSERT(isValid("\xf4\x8f\xbf\xbf"));
+  CPPUNIT_ASSERT(isValid(string(40, 'x') + "P\xc5\x99\xc3\xadli\xc5\xa1 \xc5\xbelu\xc5\xa5ou\xc4\x8dk\xc3\xbd" + string(40, 'y')));
+}
+
+void EBOOKUTF8ScanTest::testInvalidUTF8()
+{
+  // stray continuation byte
+  CPPUNIT_ASSERT(!isValid("\x80"));
+  CPPUNIT_ASSERT(!isValid(string(50, 'x') + "\xbf"));
+  // overlong forms
+  CPPUNIT_ASSERT(!isValid("\xc0\x80"));
+  CPPUNIT_ASSERT(!isValid("\xc1\xbf"));
+  CPPUNIT_ASSERT(!isValid("\xe0\x9f\xbf"));
+  CPPUNIT_ASSERT(!isValid("\xf0\x8f\xbf\xbf"));
+  // surrogates
+  CPPUNIT_ASSERT(!isValid("\xed\xa0\x80"));
+  // above U+10FFFF
+  CPPUNIT_ASSERT(!isValid("\xf4\x90\x80\x80"));
+  CPPUNIT_ASSERT(!isValid("\xf5\x80\x80\x80"));
+  CPPUNIT_ASSERT(!isValid("\xff"));
+  // truncated sequences
+  CPPUNIT_ASSERT(!isValid("\xc5"));
+  CPPUNIT_ASSERT(!isValid("\xe2\x82"));
+  CPPUNIT_ASSERT(!isValid("\xf0\x9f\x98"));
+  // missing continuation byte
+  CPPUNIT_ASSERT(!isValid("\xc5" "a"));
+  CPPUNIT_ASSERT(!isValid("\xe2\x82" "a"));
+  // cp1252
+  CPPUNIT_ASSERT(!isValid("caf\xe9 cr\xe8me"));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKUTF8ScanTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,236 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "libebook_utils.h"
+#include "EBOOKCharsetConverter.h"
+#include "EBOOKMemoryStream.h"
+#include "EBOOKUTF8Stream.h"
+
+using libebook::EBOOKCharsetConverter;
+using libebook::EBOOKMemoryStream;
+using libebook::EBOOKUTF8Stream;
+
+using std::string;
+using std::vector;
+
+namespace test
+{
+
+namespace
+{
+
+string readAll(librevenge::RVNGInputStream &stream, const unsigned long chunk)
+{
+  string text;
+  while (!stream.isEnd())
+  {
+    unsigned long readBytes = 0;
+    const unsigned char *const data = stream.read(chunk, readBytes);
+    CPPUNIT_ASSERT(data);
+    CPPUNIT_ASSERT(0 < readBytes);
+    text.append(reinterpret_cast<const char *>(data), readBytes);
+  }
+  return text;
+}
+
+/// Create a long cp1252 text and its UTF-8 form.
+void makeText(const unsigned long length, vector<unsigned char> &text, string &utf8)
+{
+  for (unsigned long i = 0; length != i; ++i)
+  {
+    if (0 == i % 7)
+    {
+      text.push_back(0xe9);
+      utf8.append("\xc3\xa9");
+    }
+    else
+    {
+      const auto c = char('a' + i % 26);
+      text.push_back((unsigned char) c);
+      utf8.push_back(c);
+    }
+  }
+}
+
+/// A stream that refuses to seek to its end, like a stream that would
+/// have to produce all its content for it.
+class NoSeekToEndStream : public EBOOKMemoryStream
+{
+public:
+  NoSeekToEndStream(const unsigned char *const data, const unsigned length)
+    : EBOOKMemoryStream(data, length)
+  {
+  }
+
+  int seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType) override
+  {
+    CPPUNIT_ASSERT(librevenge::RVNG_SEEK_END != seekType);
+    return EBOOKMemoryStream::seek(offset, seekType);
+  }
+};
+
+}
+
+class EBOOKUTF8StreamTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(EBOOKUTF8StreamTest);
+  CPPUNIT_TEST(testConvertAll);
+  CPPUNIT_TEST(testStreaming);
+  CPPUNIT_TEST(testStreamingSeek);
+  CPPUNIT_TEST(testStreamingSplitCharacters);
+  CPPUNIT_TEST(testStreamingLazyInput);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testConvertAll();
+  void testStreaming();
+  void testStreamingSeek();
+  void testStreamingSplitCharacters();
+  void testStreamingLazyInput();
+};
+
+void EBOOKUTF8StreamTest::setUp()
+{
+}
+
+void EBOOKUTF8StreamTest::tearDown()
+{
+}
+
+void EBOOKUTF8StreamTest::testConvertAll()
+{
+  const unsigned char data[] = "caf\xe9";
+  EBOOKMemoryStream input(data, sizeof(data) - 1);
+  EBOOKCharsetConverter converter("cp1252");
+  EBOOKUTF8Stream stream(&input, &converter);
+
+  CPPUNIT_ASSERT_EQUAL(string("caf\xc3\xa9"), readAll(stream, 100));
+}
+
+void EBOOKUTF8StreamTest::testStreaming()
+{
+  vector<unsigned char> text;
+  string utf8;
+  makeText(100000, text, utf8);
+
+  EBOOKMemoryStream input(&text[0], unsigned(text.size()));
+  std::unique_ptr<EBOOKUTF8Stream> stream;
+  {
+    // the converter is only needed in constructor
+    EBOOKCharsetConverter converter("cp1252");
+    stream.reset(new EBOOKUTF8Stream(&input, &converter, EBOOKUTF8Stream::MODE_STREAMING));
+  }
+
+  CPPUNIT_ASSERT(!stream->isEnd());
+  CPPUNIT_ASSERT_EQUAL(utf8, readAll(*stream, 1000));
+  CPPUNIT_ASSERT(stream->isEnd());
+  CPPUNIT_ASSERT_EQUAL(long(utf8.size()), stream->tell());
+}
+
+void EBOOKUTF8StreamTest::testStreamingSeek()
+{
+  vector<unsigned char> text;
+  string utf8;
+  makeText(100000, text, utf8);
+
+  EBOOKMemoryStream input(&text[0], unsigned(text.size()));
+  EBOOKCharsetConverter converter("cp1252");
+  EBOOKUTF8Stream stream(&input, &converter, EBOOKUTF8Stream::MODE_STREAMING);
+
+  CPPUNIT_ASSERT_EQUAL(0, stream.seek(0, librevenge::RVNG_SEEK_END));
+  CPPUNIT_ASSERT_EQUAL(long(utf8.size()), stream.tell());
+  CPPUNIT_ASSERT(stream.isEnd());
+
+  CPPUNIT_ASSERT_EQUAL(0, stream.seek(-10, librevenge::RVNG_SEEK_CUR));
+  CPPUNIT_ASSERT_EQUAL(utf8.substr(utf8.size() - 10), readAll(stream, 3));
+
+  // seek back to the start
+  CPPUNIT_ASSERT_EQUAL(0, stream.seek(5, librevenge::RVNG_SEEK_SET));
+  CPPUNIT_ASSERT_EQUAL(utf8.substr(5), readAll(stream, 4096));
+
+  CPPUNIT_ASSERT_EQUAL(0, stream.seek(50000, librevenge::RVNG_SEEK_SET));
+  CPPUNIT_ASSERT_EQUAL(utf8.substr(50000, 100), string(reinterpret_cast<const char *>(libebook::readNBytes(&stream, 100)), 100));
+
+  CPPUNIT_ASSERT(0 != stream.seek(long(utf8.size()) + 1, librevenge::RVNG_SEEK_SET));
+  CPPUNIT_ASSERT(0 != stream.seek(-1, librevenge::RVNG_SEEK_SET));
+  CPPUNIT_ASSERT_EQUAL(50100l, stream.tell());
+}
+
+void EBOOKUTF8StreamTest::testStreamingSplitCharacters()
+{
+  // UTF-16BE with a prefix of odd length, so characters are split
+  // between the input parts
+  vector<unsigned char> text(1, 'x');
+  string utf8;
+  for (unsigned i = 0; 30000 != i; ++i)
+  {
+    if (0 == i % 5)
+    {
+      // U+1F600
+      const unsigned char c[] = { 0xd8, 0x3d, 0xde, 0x00 };
+      text.insert(text.end(), c, c + 4);
+      utf8.append("\xf0\x9f\x98\x80");
+    }
+    else
+    {
+      // U+017E
+      text.push_back(0x01);
+      text.push_back(0x7e);
+      utf8.append("\xc5\xbe");
+    }
+  }
+
+  EBOOKMemoryStream input(&text[0], unsigned(text.size()));
+  input.seek(1, librevenge::RVNG_SEEK_SET);
+  EBOOKCharsetConverter converter("UTF-16BE");
+  EBOOKUTF8Stream stream(&input, &converter, EBOOKUTF8Stream::MODE_STREAMING);
+
+  CPPUNIT_ASSERT_EQUAL(utf8, readAll(stream, 777));
+}
+
+void EBOOKUTF8StreamTest::testStreamingLazyInput()
+{
+  string text;
+  for (unsigned i = 0; 100000 != i; ++i)
+    text.push_back(0 == i % 61 ? '\n' : char('a' + i % 26));
+  const auto *const data = reinterpret_cast<const unsigned char *>(text.data());
+
+  {
+    // the encoding is guessed
+    NoSeekToEndStream input(data, unsigned(text.size()));
+    EBOOKUTF8Stream stream(&input, nullptr, EBOOKUTF8Stream::MODE_STREAMING);
+    CPPUNIT_ASSERT_EQUAL(text, readAll(stream, 1000));
+  }
+
+  {
+    NoSeekToEndStream input(data, 0);
+    EBOOKUTF8Stream stream(&input, nullptr, EBOOKUTF8Stream::MODE_STREAMING);
+    CPPUNIT_ASSERT(stream.isEnd());
+  }
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKUTF8StreamTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,217 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <zlib.h>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "EBOOKMemoryStream.h"
+#include "EBOOKZlibStream.h"
+
+using libebook::EBOOKMemoryStream;
+using libebook::EBOOKZlibStream;
+
+using std::vector;
+
+namespace test
+{
+
+namespace
+{
+
+vector<unsigned char> makeText(const unsigned long length)
+{
+  vector<unsigned char> text;
+  text.reserve(length);
+  for (unsigned long i = 0; length != i; ++i)
+    text.push_back((unsigned char)('a' + (i * 7 + i / 13) % 26));
+  return text;
+}
+
+vector<unsigned char> compress(const vector<unsigned char> &data)
+{
+  uLongf length = compressBound(uLong(data.size()));
+  vector<unsigned char> compressed(length);
+  CPPUNIT_ASSERT(Z_OK == compress2(&compressed[0], &length, &data[0], uLong(data.size()), Z_BEST_COMPRESSION));
+  compressed.resize(length);
+  return compressed;
+}
+
+}
+
+class EBOOKZlibStreamTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(EBOOKZlibStreamTest);
+  CPPUNIT_TEST(testRead);
+  CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST(testKnownSize);
+  CPPUNIT_TEST(testDamaged);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testRead();
+  void testSeek();
+  void testKnownSize();
+  void testDamaged();
+};
+
+void EBOOKZlibStreamTest::setUp()
+{
+}
+
+void EBOOKZlibStreamTest::tearDown()
+{
+}
+
+void EBOOKZlibStreamTest::testRead()
+{
+  const vector<unsigned char> text = makeText(200000);
+  const vector<unsigned char> compressed = compress(text);
+  EBOOKMemoryStream input(&compressed[0], unsigned(compressed.size()));
+  EBOOKZlibStream strm(&input);
+
+  vector<unsigned char> inflated;
+  while (!strm.isEnd())
+  {
+    unsigned long readBytes = 0;
+    const unsigned char *const s = strm.read(1000, readBytes);
+    CPPUNIT_ASSERT(s);
+    CPPUNIT_ASSERT(0 < readBytes);
+    inflated.insert(inflated.end(), s, s + readBytes);
+  }
+
+  CPPUNIT_ASSERT(text == inflated);
+  CPPUNIT_ASSERT_EQUAL(long(text.size()), strm.tell());
+}
+
+void EBOOKZlibStreamTest::testSeek()
+{
+  const vector<unsigned char> text = makeText(200000);
+  const vector<unsigned char> compressed = compress(text);
+  EBOOKMemoryStream input(&compressed[0], unsigned(compressed.size()));
+  EBOOKZlibStream strm(&input);
+  unsigned long readBytes = 0;
+
+  CPPUNIT_ASSERT(0 == strm.seek(150000, librevenge::RVNG_SEEK_SET));
+  CPPUNIT_ASSERT_EQUAL(150000L, strm.tell());
+  const unsigned char *s = strm.read(10, readBytes);
+  CPPUNIT_ASSERT_EQUAL(10ul, readBytes);
+  CPPUNIT_ASSERT(std::equal(s, s + 10, text.begin() + 150000));
+
+  // seeking before the kept data
+  CPPUNIT_ASSERT(0 == strm.seek(5, librevenge::RVNG_SEEK_SET));
+  s = strm.read(10, readBytes);
+  CPPUNIT_ASSERT_EQUAL(10ul, readBytes);
+  CPPUNIT_ASSERT(std::equal(s, s + 10, text.begin() + 5));
+
+  CPPUNIT_ASSERT(0 == strm.seek(0, librevenge::RVNG_SEEK_END));
+  CPPUNIT_ASSERT(strm.isEnd());
+  CPPUNIT_ASSERT_EQUAL(long(text.size()), strm.tell());
+  CPPUNIT_ASSERT(0 != strm.seek(1, librevenge::RVNG_SEEK_END));
+  CPPUNIT_ASSERT(0 == strm.seek(-3, librevenge::RVNG_SEEK_CUR));
+  s = strm.read(10, readBytes);
+  CPPUNIT_ASSERT_EQUAL(3ul, readBytes);
+  CPPUNIT_ASSERT(std::equal(s, s + 3, text.end() - 3));
+
+  CPPUNIT_ASSERT(0 == strm.seek(0, librevenge::RVNG_SEEK_SET));
+  s = strm.read(text.size(), readBytes);
+  CPPUNIT_ASSERT_EQUAL((unsigned long) text.size(), readBytes);
+  CPPUNIT_ASSERT(std::equal(s, s + readBytes, text.begin()));
+}
+
+void EBOOKZlibStreamTest::testKnownSize()
+{
+  const vector<unsigned char> text = makeText(50000);
+  const vector<unsigned char> compressed = compress(text);
+  const unsigned long sizes[] = { text.size(), text.size() + 100, text.size() - 100, 1, 0 };
+
+  for (unsigned i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+  {
+    EBOOKMemoryStream input(&compressed[0], unsigned(compressed.size()));
+    EBOOKZlibStream strm(&input, sizes[i]);
+
+    unsigned long readBytes = 0;
+    const unsigned char *const s = strm.read(text.size() + 1, readBytes);
+    CPPUNIT_ASSERT_EQUAL((unsigned long) text.size(), readBytes);
+    CPPUNIT_ASSERT(std::equal(s, s + readBytes, text.begin()));
+    CPPUNIT_ASSERT(strm.isEnd());
+  }
+}
+
+void EBOOKZlibStreamTest::testDamaged()
+{
+  const vector<unsigned char> text = makeText(200000);
+  const vector<unsigned char> compressed = compress(text);
+  unsigned long readBytes = 0;
+
+  {
+    EBOOKMemoryStream input(&compressed[0], unsigned(compressed.size()));
+    EBOOKZlibStream strm(&input);
+    CPPUNIT_ASSERT(0 == strm.seek(0, librevenge::RVNG_SEEK_END));
+    CPPUNIT_ASSERT(!strm.hasFailed());
+  }
+
+  {
+    // a truncated stream is not damaged
+    EBOOKMemoryStream input(&compressed[0], unsigned(compressed.size() / 2));
+    EBOOKZlibStream strm(&input);
+    CPPUNIT_ASSERT(strm.read(text.size(), readBytes));
+    CPPUNIT_ASSERT(readBytes < text.size());
+    CPPUNIT_ASSERT(strm.isEnd());
+    CPPUNIT_ASSERT(!strm.hasFailed());
+  }
+
+  {
+    // a block of the reserved type 3 after a flushed part of the text
+    vector<unsigned char> damaged(compressBound(uLong(text.size())));
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    CPPUNIT_ASSERT(Z_OK == deflateInit(&zstream, Z_BEST_COMPRESSION));
+    zstream.next_in = const_cast<Bytef *>(&text[0]);
+    zstream.avail_in = uInt(text.size() / 2);
+    zstream.next_out = &damaged[0];
+    zstream.avail_out = uInt(damaged.size());
+    CPPUNIT_ASSERT(Z_OK == deflate(&zstream, Z_FULL_FLUSH));
+    damaged.resize(zstream.total_out);
+    deflateEnd(&zstream);
+    damaged.push_back(0x07);
+    damaged.push_back(0);
+
+    EBOOKMemoryStream input(&damaged[0], unsigned(damaged.size()));
+    EBOOKZlibStream strm(&input);
+    CPPUNIT_ASSERT(strm.read(text.size(), readBytes));
+    CPPUNIT_ASSERT_EQUAL((unsigned long) text.size() / 2, readBytes);
+    CPPUNIT_ASSERT(strm.isEnd());
+    CPPUNIT_ASSERT(strm.hasFailed());
+
+    // the whole data are inflated at once if the size is known
+    EBOOKMemoryStream sizedInput(&damaged[0], unsigned(damaged.size()));
+    EBOOKZlibStream sized(&sizedInput, text.size());
+    CPPUNIT_ASSERT(sized.hasFailed());
+  }
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EBOOKZlibStreamTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
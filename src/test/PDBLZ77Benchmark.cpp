@@ -0,0 +1,225 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Compare PDBLZ77Stream::unpack with the original byte-wise decoder.
+ *
+ * Build it with "make lz77bench" and run it without arguments.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "libebook_utils.h"
+#include "PDBLZ77Stream.h"
+
+using libebook::PDBLZ77Stream;
+
+using std::vector;
+
+namespace
+{
+
+const unsigned RECORD_SIZE = 4096;
+const unsigned RECORD_COUNT = 256;
+const unsigned ITERATIONS = 200;
+
+/// The decoder used before PDBLZ77Stream::unpack, for comparison.
+void unpackReference(const vector<unsigned char> &input, vector<unsigned char> &buffer)
+{
+  vector<unsigned char>::size_type pos = 0;
+  while (pos != input.size())
+  {
+    const unsigned char c = input[pos++];
+
+    if ((c == 0x0) || ((c >= 0x9) && (c <= 0x7f)))
+    {
+      buffer.push_back(c);
+    }
+    else if ((c >= 0x1) && (c <= 0x8))
+    {
+      if (input.size() - pos < c)
+        throw libebook::GenericException();
+      buffer.insert(buffer.end(), input.begin() + long(pos), input.begin() + long(pos + c));
+      pos += c;
+    }
+    else if ((c >= 0x80) && (c <= 0xbf))
+    {
+      if (pos == input.size())
+        throw libebook::GenericException();
+
+      const unsigned combined = ((c & 0x3fu) << 8) | input[pos++];
+      const unsigned distance = (combined & 0xfff8) >> 3;
+      const unsigned length = (combined & 0x7) + 3;
+
+      if ((0 == distance) || (distance > buffer.size()))
+        throw libebook::GenericException();
+
+      if (length <= distance)
+      {
+        for (vector<unsigned char>::size_type i = buffer.size() - distance, last = i + length; i != last; ++i)
+          buffer.push_back(buffer[i]);
+      }
+      else
+      {
+        const unsigned char repeated = *(buffer.end() - long(distance));
+        buffer.insert(buffer.end(), length, repeated);
+      }
+    }
+    else
+    {
+      buffer.push_back(' ');
+      buffer.push_back(c ^ 0x80);
+    }
+  }
+}
+
+/** Pack a record with a simple greedy matcher.
+  *
+  * Overlapping back-references are only used for repeated characters,
+  * which both decoders handle the same way.
+  */
+void pack(const unsigned char *const input, const unsigned length, vector<unsigned char> &output)
+{
+  unsigned pos = 0;
+  while (pos != length)
+  {
+    unsigned bestLength = 0;
+    unsigned bestDistance = 0;
+    for (unsigned distance = 1; (distance <= pos) && (distance < 2048); ++distance)
+    {
+      unsigned len = 0;
+      while ((len < 10) && (pos + len < length) && (input[pos + len] == input[pos + len - distance]))
+        ++len;
+      if ((distance > 1) && (len > distance))
+        len = distance;
+      if (len > bestLength)
+      {
+        bestLength = len;
+        bestDistance = distance;
+      }
+    }
+
+    if (bestLength >= 3)
+    {
+      const unsigned combined = (bestDistance << 3) | (bestLength - 3);
+      output.push_back((unsigned char)(0x80 | (combined >> 8)));
+      output.push_back((unsigned char)(combined & 0xff));
+      pos += bestLength;
+    }
+    else if ((' ' == input[pos]) && (pos + 1 != length) && (0x40 <= input[pos + 1]) && (0x7f >= input[pos + 1]))
+    {
+      output.push_back((unsigned char)(input[pos + 1] ^ 0x80));
+      pos += 2;
+    }
+    else if ((0x0 == input[pos]) || ((0x9 <= input[pos]) && (0x7f >= input[pos])))
+    {
+      output.push_back(input[pos]);
+      ++pos;
+    }
+    else
+    {
+      output.push_back(1);
+      output.push_back(input[pos]);
+      ++pos;
+    }
+  }
+}
+
+void generateText(vector<unsigned char> &text)
+{
+  const char *const words[] =
+  {
+    "the", "of", "and", "a", "to", "in", "is", "you", "that", "it", "he", "was", "for", "on", "are",
+    "as", "with", "his", "they", "I", "at", "be", "this", "have", "from", "or", "one", "had", "by",
+    "word", "but", "not", "what", "all", "were", "we", "when", "your", "can", "said", "there",
+    "chapter", "\xe9t\xe9", "----------", "....."
+  };
+
+  std::srand(42);
+  while (text.size() < RECORD_SIZE * RECORD_COUNT)
+  {
+    const char *const word = words[unsigned(std::rand()) % EBOOK_NUM_ELEMENTS(words)];
+    text.insert(text.end(), word, word + std::strlen(word));
+    text.push_back((0 == std::rand() % 12) ? '\n' : ' ');
+  }
+  text.resize(RECORD_SIZE * RECORD_COUNT);
+}
+
+}
+
+int main()
+{
+  vector<unsigned char> text;
+  generateText(text);
+
+  vector<vector<unsigned char> > records(RECORD_COUNT);
+  unsigned long packedSize = 0;
+  for (unsigned i = 0; i != RECORD_COUNT; ++i)
+  {
+    pack(&text[i * RECORD_SIZE], RECORD_SIZE, records[i]);
+    packedSize += records[i].size();
+  }
+  std::printf("%u records, %lu bytes packed to %lu bytes\n", RECORD_COUNT, (unsigned long) text.size(), packedSize);
+
+  // check that both decoders produce the same output
+  vector<unsigned char> output(RECORD_SIZE);
+  for (unsigned i = 0; i != RECORD_COUNT; ++i)
+  {
+    vector<unsigned char> reference;
+    unpackReference(records[i], reference);
+    unsigned long length = 0;
+    if (!PDBLZ77Stream::unpack(&records[i][0], records[i].size(), &output[0], output.size(), length)
+        || (RECORD_SIZE != length) || (reference.size() != length)
+        || (0 != std::memcmp(&reference[0], &output[0], length))
+        || (0 != std::memcmp(&text[i * RECORD_SIZE], &output[0], length)))
+    {
+      std::fprintf(stderr, "record %u differs\n", i);
+      return 1;
+    }
+  }
+
+  unsigned long checksum = 0;
+
+  const auto referenceStart = std::chrono::steady_clock::now();
+  for (unsigned n = 0; n != ITERATIONS; ++n)
+  {
+    for (unsigned i = 0; i != RECORD_COUNT; ++i)
+    {
+      vector<unsigned char> reference;
+      unpackReference(records[i], reference);
+      checksum += reference.back();
+    }
+  }
+  const std::chrono::duration<double> referenceTime = std::chrono::steady_clock::now() - referenceStart;
+
+  const auto unpackStart = std::chrono::steady_clock::now();
+  for (unsigned n = 0; n != ITERATIONS; ++n)
+  {
+    for (unsigned i = 0; i != RECORD_COUNT; ++i)
+    {
+      vector<unsigned char> unpacked(RECORD_SIZE);
+      unsigned long length = 0;
+      PDBLZ77Stream::unpack(&records[i][0], records[i].size(), &unpacked[0], unpacked.size(), length);
+      checksum += unpacked[length - 1];
+    }
+  }
+  const std::chrono::duration<double> unpackTime = std::chrono::steady_clock::now() - unpackStart;
+
+  const double megabytes = double(text.size()) * ITERATIONS / (1024 * 1024);
+  std::printf("byte-wise: %8.1f MiB/s\n", megabytes / referenceTime.count());
+  std::printf("unpack:    %8.1f MiB/s\n", megabytes / unpackTime.count());
+  std::printf("(checksum %lu)\n", checksum);
+
+  return 0;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -7,11 +7,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <cstring>
+
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <librevenge-stream/librevenge-stream.h>
 
+#include "libebook_utils.h"
 #include "PDBLZ77Stream.h"
 
 using libebook::PDBLZ77Stream;
@@ -28,10 +31,16 @@ public:
 private:
   CPPUNIT_TEST_SUITE(PDBLZ77StreamTest);
   CPPUNIT_TEST(testRead);
+  CPPUNIT_TEST(testReadWithSize);
+  CPPUNIT_TEST(testUnpack);
+  CPPUNIT_TEST(testUnpackInvalid);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testRead();
+  void testReadWithSize();
+  void testUnpack();
+  void testUnpackInvalid();
 };
 
 void PDBLZ77StreamTest::setUp()
@@ -64,6 +73,91 @@ void PDBLZ77StreamTest::testRead()
   CPPUNIT_ASSERT_MESSAGE("reading did not exhaust the stream", stream.isEnd());
 }
 
+void PDBLZ77StreamTest::testReadWithSize()
+{
+  const unsigned char unpacked[] = "abc dee abc";
+  const unsigned char data[] = "\x61\x62\x01\x63\xe4\x02\x65\x65\x20\x80\x40";
+
+  for (unsigned long size = 1; 2 * sizeof(unpacked) != size; ++size)
+  {
+    librevenge::RVNGStringStream dataStream(data, sizeof(data));
+    PDBLZ77Stream stream(&dataStream, size);
+
+    unsigned long readBytes = 0;
+    const unsigned char *const s = stream.read(2 * sizeof(unpacked), readBytes);
+    CPPUNIT_ASSERT_EQUAL(sizeof(unpacked), size_t(readBytes));
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp(unpacked, s, sizeof(unpacked)));
+    CPPUNIT_ASSERT(stream.isEnd());
+  }
+}
+
+void PDBLZ77StreamTest::testUnpack()
+{
+  unsigned char output[32];
+  unsigned long length = 0;
+
+  // literal runs and space + character
+  {
+    const unsigned char data[] = "\x03\x80\x81\x82\xc1";
+    CPPUNIT_ASSERT(PDBLZ77Stream::unpack(data, 5, output, sizeof(output), length));
+    CPPUNIT_ASSERT_EQUAL(5ul, length);
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp("\x80\x81\x82 A", output, 5));
+  }
+
+  // repeated character
+  {
+    const unsigned char data[] = "a\x80\x0f";
+    CPPUNIT_ASSERT(PDBLZ77Stream::unpack(data, 3, output, sizeof(output), length));
+    CPPUNIT_ASSERT_EQUAL(11ul, length);
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp("aaaaaaaaaaa", output, 11));
+  }
+
+  // repeated sequence
+  {
+    const unsigned char data[] = "ab\x80\x11";
+    CPPUNIT_ASSERT(PDBLZ77Stream::unpack(data, 4, output, sizeof(output), length));
+    CPPUNIT_ASSERT_EQUAL(6ul, length);
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp("ababab", output, 6));
+  }
+
+  // long back-reference
+  {
+    const unsigned char data[] = "abcdefgh\x80\x47z";
+    CPPUNIT_ASSERT(PDBLZ77Stream::unpack(data, 11, output, sizeof(output), length));
+    CPPUNIT_ASSERT_EQUAL(19ul, length);
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp("abcdefghabcdefghabz", output, 19));
+
+    // exactly fitting output
+    CPPUNIT_ASSERT(PDBLZ77Stream::unpack(data, 11, output, 19, length));
+    CPPUNIT_ASSERT_EQUAL(19ul, length);
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp("abcdefghabcdefghabz", output, 19));
+
+    // too short output
+    CPPUNIT_ASSERT(!PDBLZ77Stream::unpack(data, 11, output, 18, length));
+    CPPUNIT_ASSERT(!PDBLZ77Stream::unpack(data, 11, output, 12, length));
+    CPPUNIT_ASSERT(!PDBLZ77Stream::unpack(data, 11, output, 0, length));
+  }
+
+  CPPUNIT_ASSERT_EQUAL(0ul, PDBLZ77Stream::getMaxUnpackedLength(0));
+  CPPUNIT_ASSERT_EQUAL(10ul, PDBLZ77Stream::getMaxUnpackedLength(2));
+}
+
+void PDBLZ77StreamTest::testUnpackInvalid()
+{
+  unsigned char output[32];
+  unsigned long length = 0;
+
+  // truncated literal run
+  CPPUNIT_ASSERT_THROW(PDBLZ77Stream::unpack(reinterpret_cast<const unsigned char *>("\x02"), 1, output, sizeof(output), length), libebook::GenericException);
+  CPPUNIT_ASSERT_THROW(PDBLZ77Stream::unpack(reinterpret_cast<const unsigned char *>("\x02" "a"), 2, output, sizeof(output), length), libebook::EndOfStreamException);
+  // truncated back-reference
+  CPPUNIT_ASSERT_THROW(PDBLZ77Stream::unpack(reinterpret_cast<const unsigned char *>("a\x80"), 2, output, sizeof(output), length), libebook::GenericException);
+  // zero distance
+  CPPUNIT_ASSERT_THROW(PDBLZ77Stream::unpack(reinterpret_cast<const unsigned char *>("a\x80\x00"), 3, output, sizeof(output), length), libebook::GenericException);
+  // distance before the start of the data
+  CPPUNIT_ASSERT_THROW(PDBLZ77Stream::unpack(reinterpret_cast<const unsigned char *>("a\x80\x10"), 3, output, sizeof(output), length), libebook::GenericException);
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(PDBLZ77StreamTest);
 
 }
@@ -0,0 +1,206 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libe-book project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "libebook_utils.h"
+#include "EBOOKMemoryStream.h"
+#include "PDBParser.h"
+
+using libebook::EBOOKMemoryStream;
+using libebook::PDBParser;
+
+using std::vector;
+
+namespace test
+{
+
+namespace
+{
+
+const unsigned TEST_TYPE = PDB_CODE("TEST");
+const unsigned TEST_CREATOR = PDB_CODE("Test");
+
+void appendU16(vector<unsigned char> &data, const unsigned value)
+{
+  data.push_back((unsigned char)(value >> 8));
+  data.push_back((unsigned char)(value & 0xff));
+}
+
+void appendU32(vector<unsigned char> &data, const unsigned value)
+{
+  appendU16(data, value >> 16);
+  appendU16(data, value & 0xffff);
+}
+
+/** Create a PDB file with an empty index record and data records of given sizes.
+  */
+vector<unsigned char> makePDB(const vector<unsigned long> &sizes)
+{
+  vector<unsigned char> pdb(32, 0); // name
+  pdb.resize(pdb.size() + 2 + 2 + 6 * 4, 0); // attributes, version, dates, IDs
+  appendU32(pdb, TEST_TYPE);
+  appendU32(pdb, TEST_CREATOR);
+  appendU32(pdb, 0); // unique ID seed
+  appendU32(pdb, 0); // next record list
+
+  const unsigned count = unsigned(sizes.size()) + 1;
+  appendU16(pdb, count);
+  unsigned long offset = 78 + 8 * count + 2;
+  appendU32(pdb, unsigned(offset));
+  appendU32(pdb, 0);
+  offset += 4; // index record
+  for (const unsigned long size : sizes)
+  {
+    appendU32(pdb, unsigned(offset));
+    appendU32(pdb, 0);
+    offset += size;
+  }
+  appendU16(pdb, 0);
+
+  pdb.resize(pdb.size() + 4, 0);
+  for (vector<unsigned long>::size_type i = 0; sizes.size() != i; ++i)
+    pdb.resize(pdb.size() + sizes[i], (unsigned char)('a' + i));
+  return pdb;
+}
+
+class TestParser : public PDBParser
+{
+public:
+  using PDBParser::CachePolicy;
+  using PDBParser::CACHE_POLICY_DROP;
+
+public:
+  explicit TestParser(librevenge::RVNGInputStream *input)
+    : PDBParser(input, nullptr, TEST_TYPE, TEST_CREATOR)
+  {
+  }
+
+  /// Get the unpacked record and return its length.
+  unsigned long getRecordLength(const unsigned n, const CachePolicy policy = CACHE_POLICY_KEEP) const
+  {
+    const std::unique_ptr<librevenge::RVNGInputStream> record(getUnpackedDataRecord(n, policy));
+    CPPUNIT_ASSERT(bool(record));
+    return libebook::getRemainingLength(record.get());
+  }
+
+private:
+  void readAppInfoRecord(librevenge::RVNGInputStream *) override {}
+  void readSortInfoRecord(librevenge::RVNGInputStream *) override {}
+  void readIndexRecord(librevenge::RVNGInputStream *) override {}
+  void readDataRecord(librevenge::RVNGInputStream *, bool) override {}
+};
+
+void assertStatistics(const PDBParser &parser, const unsigned long hits, const unsigned long misses, const unsigned long evictions)
+{
+  const PDBParser::CacheStatistics statistics = parser.getCacheStatistics();
+  CPPUNIT_ASSERT_EQUAL(hits, statistics.hits);
+  CPPUNIT_ASSERT_EQUAL(misses, statistics.misses);
+  CPPUNIT_ASSERT_EQUAL(evictions, statistics.evictions);
+}
+
+}
+
+class PDBParserTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(PDBParserTest);
+  CPPUNIT_TEST(testCacheHits);
+  CPPUNIT_TEST(testCachePolicy);
+  CPPUNIT_TEST(testCacheEvictions);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testCacheHits();
+  void testCachePolicy();
+  void testCacheEvictions();
+};
+
+void PDBParserTest::setUp()
+{
+}
+
+void PDBParserTest::tearDown()
+{
+}
+
+void PDBParserTest::testCacheHits()
+{
+  vector<unsigned long> sizes;
+  sizes.push_back(100);
+  sizes.push_back(200);
+  const vector<unsigned char> pdb = makePDB(sizes);
+  EBOOKMemoryStream input(&pdb[0], unsigned(pdb.size()));
+  TestParser parser(&input);
+
+  assertStatistics(parser, 0, 0, 0);
+  CPPUNIT_ASSERT_EQUAL(100ul, parser.getRecordLength(0));
+  assertStatistics(parser, 0, 1, 0);
+  CPPUNIT_ASSERT_EQUAL(100ul, parser.getRecordLength(0));
+  assertStatistics(parser, 1, 1, 0);
+  CPPUNIT_ASSERT_EQUAL(200ul, parser.getRecordLength(1));
+  CPPUNIT_ASSERT_EQUAL(100ul, parser.getRecordLength(0));
+  CPPUNIT_ASSERT_EQUAL(200ul, parser.getRecordLength(1));
+  assertStatistics(parser, 3, 2, 0);
+}
+
+void PDBParserTest::testCachePolicy()
+{
+  vector<unsigned long> sizes;
+  sizes.push_back(100);
+  const vector<unsigned char> pdb = makePDB(sizes);
+  EBOOKMemoryStream input(&pdb[0], unsigned(pdb.size()));
+  TestParser parser(&input);
+
+  // a dropped record is not kept...
+  CPPUNIT_ASSERT_EQUAL(100ul, parser.getRecordLength(0, TestParser::CACHE_POLICY_DROP));
+  CPPUNIT_ASSERT_EQUAL(100ul, parser.getRecordLength(0, TestParser::CACHE_POLICY_DROP));
+  assertStatistics(parser, 0, 2, 0);
+
+  // ... but it is taken from the cache if it is there already
+  CPPUNIT_ASSERT_EQUAL(100ul, parser.getRecordLength(0));
+  CPPUNIT_ASSERT_EQUAL(100ul, parser.getRecordLength(0, TestParser::CACHE_POLICY_DROP));
+  assertStatistics(parser, 1, 3, 0);
+}
+
+void PDBParserTest::testCacheEvictions()
+{
+  // the cache has space for one of these records, but not for two
+  const unsigned long size = 3 * 1024 * 1024;
+  vector<unsigned long> sizes;
+  sizes.push_back(size);
+  sizes.push_back(size);
+  const vector<unsigned char> pdb = makePDB(sizes);
+  EBOOKMemoryStream input(&pdb[0], unsigned(pdb.size()));
+  TestParser parser(&input);
+
+  CPPUNIT_ASSERT_EQUAL(size, parser.getRecordLength(0));
+  CPPUNIT_ASSERT_EQUAL(size, parser.getRecordLength(1));
+  assertStatistics(parser, 0, 2, 1);
+  CPPUNIT_ASSERT_EQUAL(size, parser.getRecordLength(1));
+  assertStatistics(parser, 1, 2, 1);
+  CPPUNIT_ASSERT_EQUAL(size, parser.getRecordLength(0));
+  assertStatistics(parser, 1, 3, 2);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PDBParserTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
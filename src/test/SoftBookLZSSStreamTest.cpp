@@ -37,11 +37,15 @@ public:
 private:
   CPPUNIT_TEST_SUITE(SoftBookLZSSStreamTest);
   CPPUNIT_TEST(testRead);
+  CPPUNIT_TEST(testReadFullWindow);
+  CPPUNIT_TEST(testReadLittleEndian);
   CPPUNIT_TEST(testSeek);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testRead();
+  void testReadFullWindow();
+  void testReadLittleEndian();
   void testSeek();
 
   void testReadAll(const std::string &text, librevenge::RVNGInputStream *stream);
@@ -89,6 +93,59 @@ void SoftBookLZSSStreamTest::testRead()
   }
 }
 
+void SoftBookLZSSStreamTest::testReadFullWindow()
+{
+  // the output is longer than the window
+  const string plain(
+    "..................\x94....\x94.........\xcb\x1f\xc5....|\xdd\x17..\xcb\x1f\xc9\xcd...|\xdd.|\xdd..|"
+  );
+  const unsigned char encoded[] =
+  {
+    0x67, 0x69, 0x51, 0xca, 0x29, 0xba, 0xf2, 0xe3, 0xfc, 0x54, 0x1b, 0xe7, 0x76, 0x2e, 0x33, 0xc9,
+    0xe6, 0x8d, 0x31, 0xa3, 0xa5, 0x05, 0x58, 0x5e, 0xab, 0xcd, 0x9b, 0xd4, 0x0e, 0x74, 0xa1, 0xdc,
+    0x70, 0xbe, 0x41, 0xfc, 0xbe, 0xfe, 0xea, 0x6b
+  };
+
+  EBOOKMemoryStream dataStream(encoded, sizeof encoded);
+  SoftBookLZSSStream::Configuration configuration;
+  configuration.offsetBits = 4;
+  configuration.lengthBits = 3;
+  configuration.uncompressedLength = unsigned(plain.size());
+  configuration.fillPos = 1;
+  configuration.fillChar = '.';
+  configuration.allowOverflow = false;
+  configuration.bigEndian = true;
+
+  SoftBookLZSSStream stream(&dataStream, configuration);
+  testReadAll(plain, &stream);
+}
+
+void SoftBookLZSSStreamTest::testReadLittleEndian()
+{
+  // the length of the output is not known in advance
+  const string plain(
+    "\xf4\x13............\xf4\x13\x4c\x64\xbf\x7f\x2f\x32\xb3\x5d\xd7\x8a\xb2\xb0\xb0..\xf4\x64\xbf\x7f"
+    "\x2f\x32\xb3\x5d\xd7\x8a\x5d\xd7\x8a\x8a\xb2\xb0\x5d\xd7\x8a\x8a\xb2\xb0\xf4\xd7\x8a\x8a\xb2\xb0"
+    "\x5d\xd7\x8a\xb2\xb0\xf4\xd7\x8a\x8a\xb2\x66\xd7\x8a\x8a\xb2\xb0\x5d\x50\xd7\x8a\x8a\xb2\xb0\x5d"
+    "\x50\x8a"
+  );
+  const unsigned char encoded[] =
+  {
+    0xfa, 0x44, 0xd5, 0x80, 0xa9, 0x96, 0x4d, 0xfd, 0xfe, 0x5f, 0x32, 0xd9, 0xd7, 0x7a, 0xf8, 0xad,
+    0x96, 0xc1, 0xc4, 0x19, 0x8d, 0x30, 0x74, 0x84, 0x82, 0xcc, 0xf7, 0x50, 0x45, 0x5c
+  };
+
+  EBOOKMemoryStream dataStream(encoded, sizeof encoded);
+  SoftBookLZSSStream::Configuration configuration;
+  configuration.offsetBits = 4;
+  configuration.lengthBits = 3;
+  configuration.fillPos = 3;
+  configuration.fillChar = '.';
+
+  SoftBookLZSSStream stream(&dataStream, configuration);
+  testReadAll(plain, &stream);
+}
+
 void SoftBookLZSSStreamTest::testSeek()
 {
 }